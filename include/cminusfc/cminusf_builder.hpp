@@ -10,6 +10,7 @@
 
 #include <map>
 #include <memory>
+#include <set>
 
 
 
@@ -50,11 +51,23 @@ class Scope {
     std::vector<std::map<std::string, Value *>> inner;
 };
 
+// 直接构造 SSA 时代表一个标量变量（局部变量或参数），只作为作用域中的键，
+// 不会出现在 IR 中；类型与对应的 alloca 相同，为指向变量类型的指针
+class SSAVariable : public Value {
+  public:
+    SSAVariable(Type *ty, const std::string &name) : Value(ty, name) {}
+    std::string print() override { return "%" + get_name(); }
+};
+
 class CminusfBuilder : public ASTVisitor {
   public:
-    CminusfBuilder() {
+    // direct_ssa 为 false 时标量变量仍使用 alloca/load/store，由 Mem2Reg 提升；
+    // fold_constants 为 true 时常量表达式在生成时即被折叠
+    CminusfBuilder(bool direct_ssa = true, bool fold_constants = true)
+        : direct_ssa_(direct_ssa) {
         module = std::make_unique<Module>();
-        builder = std::make_unique<IRBuilder>(nullptr, module.get());
+        builder = std::make_unique<IRBuilder>(nullptr, module.get(),
+                                              fold_constants);
         auto *TyVoid = module->get_void_type();
         auto *TyInt32 = module->get_int32_type();
         auto *TyFloat = module->get_float_type();
@@ -104,6 +117,29 @@ class CminusfBuilder : public ASTVisitor {
     virtual Value *visit(ASTTerm &) override final;
     virtual Value *visit(ASTCall &) override final;
 
+    // 按 Braun 等人的算法在生成 IR 的同时构造 SSA。
+    // cminus 没有取地址运算，所有非数组的局部变量与参数都直接以 SSA 值表示；
+    // 基本块的前驱全部确定后才封闭（seal），之前读到的变量先放置不完整的 phi
+    Value *create_variable(Type *ty, const std::string &name);
+    Value *load_variable(Value *var);
+    void store_variable(Value *val, Value *var);
+    void write_variable(SSAVariable *var, BasicBlock *bb, Value *val);
+    Value *read_variable(SSAVariable *var, BasicBlock *bb);
+    Value *read_variable_recursive(SSAVariable *var, BasicBlock *bb);
+    Value *add_phi_operands(SSAVariable *var, PhiInst *phi);
+    Value *try_remove_trivial_phi(PhiInst *phi);
+    void seal_block(BasicBlock *bb);
+    void finish_function();
+
+    bool direct_ssa_;
+    std::vector<std::unique_ptr<SSAVariable>> ssa_vars_;
+    // 变量在各基本块末尾的当前定值
+    std::map<SSAVariable *, std::map<BasicBlock *, Value *>> current_def_;
+    std::map<BasicBlock *, std::map<SSAVariable *, PhiInst *>> incomplete_phis_;
+    std::set<BasicBlock *> sealed_blocks_;
+    // 已移出基本块的平凡 phi，函数生成结束后统一释放
+    std::set<PhiInst *> removed_phis_;
+
     std::unique_ptr<IRBuilder> builder;
     Scope scope;
     std::unique_ptr<Module> module;
@@ -112,5 +148,6 @@ class CminusfBuilder : public ASTVisitor {
         Function *func = nullptr;
         Value* val=nullptr;
         bool is_lval=false;
+        bool is_cond=false; // 作为 if/while 条件求值时，比较结果直接以 i1 返回
     } context;
 };
\ No newline at end of file
@@ -35,6 +35,11 @@ class BasicBlock : public Value, public llvm::ilist_node<BasicBlock> {
     bool is_terminated() const;
     // Get terminator, only accept valid case use
     Instruction *get_terminator();
+    // In the phis of this block, replace incoming block old_pred by new_pred
+    void replace_phi_pred(BasicBlock *old_pred, BasicBlock *new_pred);
+    // After moving a terminator from old_pred into this block, let the phis
+    // of its successors refer to this block instead
+    void redirect_succ_phis(BasicBlock *old_pred);
 
     /****************api about Instruction****************/
     void add_instruction(Instruction *instr);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Constant.hpp"
+#include "Instruction.hpp"
+#include "Module.hpp"
+
+/**
+ * 常量折叠，IRBuilder 的折叠模式、常量传播、IPSCCP 与 InstCombine 共用；
+ * IndVarSimplify、LoopVersioning 通过折叠模式的 IRBuilder 生成代码
+ * 整数运算按 32 位补码回绕；结果未定义（除以 0、INT_MIN / -1、
+ * 超出 i32 范围的 fptosi）时不折叠，返回 nullptr
+ **/
+class ConstFolder {
+  public:
+    ConstFolder(Module *m) : module_(m) {}
+    // 二元运算与比较，比较的结果为 i1 常量
+    Constant *compute(Instruction::OpID op, Constant *value1, Constant *value2);
+    // 类型转换：sitofp、fptosi、zext
+    Constant *compute(Instruction::OpID op, Constant *value1);
+
+    // 先尝试常量折叠，再应用 x+0、x*1、x*0、x-x 等平凡恒等式，
+    // 返回可直接代替 lhs op rhs 的值；无法化简时返回 nullptr
+    Value *simplify(Instruction::OpID op, Value *lhs, Value *rhs);
+    Value *simplify(Instruction::OpID op, Value *val);
+
+    // 比较取反（a op b 为假时 a op' b 为真），仅支持整数比较：
+    // LightIR 的浮点比较是无序比较，取反后为有序比较，无法表示
+    static Instruction::OpID invert_predicate(Instruction::OpID op);
+    // 交换操作数后的等价比较，a op b 等价于 b op' a
+    static Instruction::OpID swap_predicate(Instruction::OpID op);
+
+  private:
+    Module *module_;
+
+    Constant *compute_int(Instruction::OpID op, int value1, int value2);
+    Constant *compute_fp(Instruction::OpID op, float value1, float value2);
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BasicBlock.hpp"
+#include "ConstFolder.hpp"
 #include "Function.hpp"
 #include "Instruction.hpp"
 #include "Value.hpp"
@@ -9,123 +10,199 @@ class IRBuilder {
   private:
     BasicBlock *BB_;
     Module *m_;
+    // 折叠模式：操作数均为常量时返回折叠后的常量，并在创建时应用平凡恒等式，
+    // 此时算术、比较与类型转换的 create_* 可能返回常量或已有的值而非新指令
+    bool folding_{false};
+    ConstFolder folder_;
+
+    Value *fold(Instruction::OpID op, Value *lhs, Value *rhs) {
+        return folding_ ? folder_.simplify(op, lhs, rhs) : nullptr;
+    }
+    Value *fold(Instruction::OpID op, Value *val) {
+        return folding_ ? folder_.simplify(op, val) : nullptr;
+    }
+
+    // 指令总是先追加到 BB_ 末尾，设置了 insert_pos_ 时再移动到它之前
+    Instruction *insert_pos_{nullptr};
+
+    template <typename T> T *insert(T *inst) {
+        if (insert_pos_ != nullptr) {
+            BB_->remove_instr(inst);
+            BB_->insert_before(insert_pos_, inst);
+        }
+        return inst;
+    }
 
   public:
-    IRBuilder(BasicBlock *bb, Module *m) : BB_(bb), m_(m){};
+    IRBuilder(BasicBlock *bb, Module *m, bool folding = false)
+        : BB_(bb), m_(m), folding_(folding), folder_(m){};
     ~IRBuilder() = default;
     Module *get_module() { return m_; }
     BasicBlock *get_insert_block() { return this->BB_; }
+    void set_folding(bool folding) { folding_ = folding; }
     void set_insert_point(BasicBlock *bb) {
         this->BB_ = bb;
+        this->insert_pos_ = nullptr;
     } // 在某个基本块中插入指令
-    IBinaryInst *create_iadd(Value *lhs, Value *rhs) {
-        return IBinaryInst::create_add(lhs, rhs, this->BB_);
+    void set_insert_point(Instruction *pos) {
+        this->BB_ = pos->get_parent();
+        this->insert_pos_ = pos;
+    } // 在某条指令之前插入指令
+    Value *create_iadd(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::add, lhs, rhs))
+            return val;
+        return insert(IBinaryInst::create_add(lhs, rhs, this->BB_));
     } // 创建加法指令（以及其他算术指令）
-    IBinaryInst *create_isub(Value *lhs, Value *rhs) {
-        return IBinaryInst::create_sub(lhs, rhs, this->BB_);
+    Value *create_isub(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::sub, lhs, rhs))
+            return val;
+        return insert(IBinaryInst::create_sub(lhs, rhs, this->BB_));
     }
-    IBinaryInst *create_imul(Value *lhs, Value *rhs) {
-        return IBinaryInst::create_mul(lhs, rhs, this->BB_);
+    Value *create_imul(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::mul, lhs, rhs))
+            return val;
+        return insert(IBinaryInst::create_mul(lhs, rhs, this->BB_));
     }
-    IBinaryInst *create_isdiv(Value *lhs, Value *rhs) {
-        return IBinaryInst::create_sdiv(lhs, rhs, this->BB_);
+    Value *create_isdiv(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::sdiv, lhs, rhs))
+            return val;
+        return insert(IBinaryInst::create_sdiv(lhs, rhs, this->BB_));
     }
 
-    ICmpInst *create_icmp_eq(Value *lhs, Value *rhs) {
-        return ICmpInst::create_eq(lhs, rhs, this->BB_);
-    }
-    ICmpInst *create_icmp_ne(Value *lhs, Value *rhs) {
-        return ICmpInst::create_ne(lhs, rhs, this->BB_);
-    }
-    ICmpInst *create_icmp_gt(Value *lhs, Value *rhs) {
-        return ICmpInst::create_gt(lhs, rhs, this->BB_);
-    }
-    ICmpInst *create_icmp_ge(Value *lhs, Value *rhs) {
-        return ICmpInst::create_ge(lhs, rhs, this->BB_);
-    }
-    ICmpInst *create_icmp_lt(Value *lhs, Value *rhs) {
-        return ICmpInst::create_lt(lhs, rhs, this->BB_);
-    }
-    ICmpInst *create_icmp_le(Value *lhs, Value *rhs) {
-        return ICmpInst::create_le(lhs, rhs, this->BB_);
+    Value *create_icmp_eq(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::eq, lhs, rhs))
+            return val;
+        return insert(ICmpInst::create_eq(lhs, rhs, this->BB_));
+    }
+    Value *create_icmp_ne(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::ne, lhs, rhs))
+            return val;
+        return insert(ICmpInst::create_ne(lhs, rhs, this->BB_));
+    }
+    Value *create_icmp_gt(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::gt, lhs, rhs))
+            return val;
+        return insert(ICmpInst::create_gt(lhs, rhs, this->BB_));
+    }
+    Value *create_icmp_ge(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::ge, lhs, rhs))
+            return val;
+        return insert(ICmpInst::create_ge(lhs, rhs, this->BB_));
+    }
+    Value *create_icmp_lt(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::lt, lhs, rhs))
+            return val;
+        return insert(ICmpInst::create_lt(lhs, rhs, this->BB_));
+    }
+    Value *create_icmp_le(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::le, lhs, rhs))
+            return val;
+        return insert(ICmpInst::create_le(lhs, rhs, this->BB_));
     }
 
     CallInst *create_call(Value *func, std::vector<Value *> args) {
-        return CallInst::create_call(static_cast<Function *>(func), args,
-                                     this->BB_);
+        return insert(CallInst::create_call(static_cast<Function *>(func),
+                                            args, this->BB_));
     }
 
     BranchInst *create_br(BasicBlock *if_true) {
-        return BranchInst::create_br(if_true, this->BB_);
+        return insert(BranchInst::create_br(if_true, this->BB_));
     }
     BranchInst *create_cond_br(Value *cond, BasicBlock *if_true,
                                BasicBlock *if_false) {
-        return BranchInst::create_cond_br(cond, if_true, if_false, this->BB_);
+        return insert(
+            BranchInst::create_cond_br(cond, if_true, if_false, this->BB_));
     }
 
     ReturnInst *create_ret(Value *val) {
-        return ReturnInst::create_ret(val, this->BB_);
+        return insert(ReturnInst::create_ret(val, this->BB_));
     }
     ReturnInst *create_void_ret() {
-        return ReturnInst::create_void_ret(this->BB_);
+        return insert(ReturnInst::create_void_ret(this->BB_));
     }
 
     GetElementPtrInst *create_gep(Value *ptr, std::vector<Value *> idxs) {
-        return GetElementPtrInst::create_gep(ptr, idxs, this->BB_);
+        return insert(GetElementPtrInst::create_gep(ptr, idxs, this->BB_));
     }
 
     StoreInst *create_store(Value *val, Value *ptr) {
-        return StoreInst::create_store(val, ptr, this->BB_);
+        return insert(StoreInst::create_store(val, ptr, this->BB_));
     }
     LoadInst *create_load(Value *ptr) {
         assert(ptr->get_type()->is_pointer_type() &&
                "ptr must be pointer type");
-        return LoadInst::create_load(ptr, this->BB_);
+        return insert(LoadInst::create_load(ptr, this->BB_));
     }
 
     AllocaInst *create_alloca(Type *ty) {
-        return AllocaInst::create_alloca(ty, this->BB_);
+        return insert(AllocaInst::create_alloca(ty, this->BB_));
     }
-    ZextInst *create_zext(Value *val, Type *ty) {
-        return ZextInst::create_zext(val, ty, this->BB_);
+    Value *create_zext(Value *val, Type *ty) {
+        if (auto folded = fold(Instruction::zext, val))
+            return folded;
+        return insert(ZextInst::create_zext(val, ty, this->BB_));
     }
 
-    SiToFpInst *create_sitofp(Value *val, Type *ty) {
-        return SiToFpInst::create_sitofp(val, this->BB_);
+    Value *create_sitofp(Value *val, Type *ty) {
+        if (auto folded = fold(Instruction::sitofp, val))
+            return folded;
+        return insert(SiToFpInst::create_sitofp(val, this->BB_));
     }
-    FpToSiInst *create_fptosi(Value *val, Type *ty) {
-        return FpToSiInst::create_fptosi(val, ty, this->BB_);
+    Value *create_fptosi(Value *val, Type *ty) {
+        if (auto folded = fold(Instruction::fptosi, val))
+            return folded;
+        return insert(FpToSiInst::create_fptosi(val, ty, this->BB_));
     }
 
-    FCmpInst *create_fcmp_ne(Value *lhs, Value *rhs) {
-        return FCmpInst::create_fne(lhs, rhs, this->BB_);
-    }
-    FCmpInst *create_fcmp_lt(Value *lhs, Value *rhs) {
-        return FCmpInst::create_flt(lhs, rhs, this->BB_);
-    }
-    FCmpInst *create_fcmp_le(Value *lhs, Value *rhs) {
-        return FCmpInst::create_fle(lhs, rhs, this->BB_);
-    }
-    FCmpInst *create_fcmp_ge(Value *lhs, Value *rhs) {
-        return FCmpInst::create_fge(lhs, rhs, this->BB_);
-    }
-    FCmpInst *create_fcmp_gt(Value *lhs, Value *rhs) {
-        return FCmpInst::create_fgt(lhs, rhs, this->BB_);
-    }
-    FCmpInst *create_fcmp_eq(Value *lhs, Value *rhs) {
-        return FCmpInst::create_feq(lhs, rhs, this->BB_);
+    Value *create_fcmp_ne(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::fne, lhs, rhs))
+            return val;
+        return insert(FCmpInst::create_fne(lhs, rhs, this->BB_));
+    }
+    Value *create_fcmp_lt(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::flt, lhs, rhs))
+            return val;
+        return insert(FCmpInst::create_flt(lhs, rhs, this->BB_));
+    }
+    Value *create_fcmp_le(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::fle, lhs, rhs))
+            return val;
+        return insert(FCmpInst::create_fle(lhs, rhs, this->BB_));
+    }
+    Value *create_fcmp_ge(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::fge, lhs, rhs))
+            return val;
+        return insert(FCmpInst::create_fge(lhs, rhs, this->BB_));
+    }
+    Value *create_fcmp_gt(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::fgt, lhs, rhs))
+            return val;
+        return insert(FCmpInst::create_fgt(lhs, rhs, this->BB_));
+    }
+    Value *create_fcmp_eq(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::feq, lhs, rhs))
+            return val;
+        return insert(FCmpInst::create_feq(lhs, rhs, this->BB_));
     }
 
-    FBinaryInst *create_fadd(Value *lhs, Value *rhs) {
-        return FBinaryInst::create_fadd(lhs, rhs, this->BB_);
-    }
-    FBinaryInst *create_fsub(Value *lhs, Value *rhs) {
-        return FBinaryInst::create_fsub(lhs, rhs, this->BB_);
-    }
-    FBinaryInst *create_fmul(Value *lhs, Value *rhs) {
-        return FBinaryInst::create_fmul(lhs, rhs, this->BB_);
-    }
-    FBinaryInst *create_fdiv(Value *lhs, Value *rhs) {
-        return FBinaryInst::create_fdiv(lhs, rhs, this->BB_);
+    Value *create_fadd(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::fadd, lhs, rhs))
+            return val;
+        return insert(FBinaryInst::create_fadd(lhs, rhs, this->BB_));
+    }
+    Value *create_fsub(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::fsub, lhs, rhs))
+            return val;
+        return insert(FBinaryInst::create_fsub(lhs, rhs, this->BB_));
+    }
+    Value *create_fmul(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::fmul, lhs, rhs))
+            return val;
+        return insert(FBinaryInst::create_fmul(lhs, rhs, this->BB_));
+    }
+    Value *create_fdiv(Value *lhs, Value *rhs) {
+        if (auto val = fold(Instruction::fdiv, lhs, rhs))
+            return val;
+        return insert(FBinaryInst::create_fdiv(lhs, rhs, this->BB_));
     }
 };
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "Constant.hpp"
+#include "Instruction.hpp"
+
+#include <cmath>
+
+/**
+ * 编译期组合的指令模式匹配，用法示例：
+ *   Value *x;
+ *   ConstantInt *c;
+ *   if (match(inst, m_Add(m_Value(x), m_ConstInt(c)))) ...
+ *   if (match(inst, m_c_Mul(m_Value(x), m_ConstInt(1)))) ...
+ * 每个模式都提供 bool match(Value *)，匹配成功时写入绑定的变量
+ **/
+namespace PatternMatch {
+
+template <typename Pattern> bool match(Value *val, const Pattern &pattern) {
+    return const_cast<Pattern &>(pattern).match(val);
+}
+
+// 匹配任意值
+struct AnyValue {
+    bool match(Value *val) { return val != nullptr; }
+};
+
+// 匹配任意值并绑定
+template <typename Class> struct BindTy {
+    Class *&bound;
+    explicit BindTy(Class *&v) : bound(v) {}
+    bool match(Value *val) {
+        if (auto v = dynamic_cast<Class *>(val)) {
+            bound = v;
+            return true;
+        }
+        return false;
+    }
+};
+
+// 匹配指定的值
+struct SpecificValue {
+    Value *expected;
+    bool match(Value *val) { return val == expected; }
+};
+
+// 匹配值为 expected 的整数常量（含 i1）
+struct SpecificInt {
+    int expected;
+    bool match(Value *val) {
+        auto c = dynamic_cast<ConstantInt *>(val);
+        return c != nullptr and c->get_value() == expected;
+    }
+};
+
+// 匹配值为 expected 的浮点常量，0.0 不匹配 -0.0
+struct SpecificFP {
+    float expected;
+    bool match(Value *val) {
+        auto c = dynamic_cast<ConstantFP *>(val);
+        return c != nullptr and c->get_value() == expected and
+               std::signbit(c->get_value()) == std::signbit(expected);
+    }
+};
+
+inline AnyValue m_Value() { return {}; }
+inline BindTy<Value> m_Value(Value *&v) { return BindTy<Value>(v); }
+inline BindTy<Instruction> m_Instruction(Instruction *&v) {
+    return BindTy<Instruction>(v);
+}
+inline BindTy<ConstantInt> m_ConstInt(ConstantInt *&c) {
+    return BindTy<ConstantInt>(c);
+}
+inline BindTy<ConstantFP> m_ConstFP(ConstantFP *&c) {
+    return BindTy<ConstantFP>(c);
+}
+inline BindTy<Constant> m_Constant(Constant *&c) { return BindTy<Constant>(c); }
+inline SpecificValue m_Specific(Value *v) { return {v}; }
+inline SpecificInt m_ConstInt(int v) { return {v}; }
+inline SpecificFP m_ConstFP(float v) { return {v}; }
+
+// 匹配任意常量（不绑定）
+struct AnyConstant {
+    bool match(Value *val) { return dynamic_cast<Constant *>(val) != nullptr; }
+};
+inline AnyConstant m_Constant() { return {}; }
+
+// 二元运算，Commutable 为 true 时也尝试交换操作数
+template <typename LHS, typename RHS, Instruction::OpID Op,
+          bool Commutable = false>
+struct BinaryOpMatch {
+    LHS lhs;
+    RHS rhs;
+    bool match(Value *val) {
+        auto inst = dynamic_cast<Instruction *>(val);
+        if (inst == nullptr or inst->get_instr_type() != Op or
+            inst->get_num_operand() != 2)
+            return false;
+        if (lhs.match(inst->get_operand(0)) and rhs.match(inst->get_operand(1)))
+            return true;
+        return Commutable and lhs.match(inst->get_operand(1)) and
+               rhs.match(inst->get_operand(0));
+    }
+};
+
+#define BINARY_MATCHER(NAME, OP, COMMUTABLE)                                  \
+    template <typename LHS, typename RHS>                                      \
+    BinaryOpMatch<LHS, RHS, Instruction::OP, COMMUTABLE> NAME(const LHS &l,    \
+                                                              const RHS &r) {  \
+        return {l, r};                                                         \
+    }
+
+BINARY_MATCHER(m_Add, add, false)
+BINARY_MATCHER(m_Sub, sub, false)
+BINARY_MATCHER(m_Mul, mul, false)
+BINARY_MATCHER(m_SDiv, sdiv, false)
+BINARY_MATCHER(m_FAdd, fadd, false)
+BINARY_MATCHER(m_FSub, fsub, false)
+BINARY_MATCHER(m_FMul, fmul, false)
+BINARY_MATCHER(m_FDiv, fdiv, false)
+BINARY_MATCHER(m_c_Add, add, true)
+BINARY_MATCHER(m_c_Mul, mul, true)
+BINARY_MATCHER(m_c_FAdd, fadd, true)
+BINARY_MATCHER(m_c_FMul, fmul, true)
+
+#undef BINARY_MATCHER
+
+// 一元类型转换
+template <typename Operand, Instruction::OpID Op> struct CastMatch {
+    Operand operand;
+    bool match(Value *val) {
+        auto inst = dynamic_cast<Instruction *>(val);
+        return inst != nullptr and inst->get_instr_type() == Op and
+               operand.match(inst->get_operand(0));
+    }
+};
+
+template <typename Operand>
+CastMatch<Operand, Instruction::zext> m_ZExt(const Operand &op) {
+    return {op};
+}
+template <typename Operand>
+CastMatch<Operand, Instruction::sitofp> m_SIToFP(const Operand &op) {
+    return {op};
+}
+template <typename Operand>
+CastMatch<Operand, Instruction::fptosi> m_FPToSI(const Operand &op) {
+    return {op};
+}
+
+// 比较指令，匹配成功时将谓词写入 pred
+template <typename LHS, typename RHS, bool IsFloat> struct CmpMatch {
+    Instruction::OpID &pred;
+    LHS lhs;
+    RHS rhs;
+    bool match(Value *val) {
+        auto inst = dynamic_cast<Instruction *>(val);
+        if (inst == nullptr or (IsFloat ? not inst->is_fcmp()
+                                        : not inst->is_cmp()))
+            return false;
+        if (lhs.match(inst->get_operand(0)) and
+            rhs.match(inst->get_operand(1))) {
+            pred = inst->get_instr_type();
+            return true;
+        }
+        return false;
+    }
+};
+
+template <typename LHS, typename RHS>
+CmpMatch<LHS, RHS, false> m_ICmp(Instruction::OpID &pred, const LHS &l,
+                                 const RHS &r) {
+    return {pred, l, r};
+}
+template <typename LHS, typename RHS>
+CmpMatch<LHS, RHS, true> m_FCmp(Instruction::OpID &pred, const LHS &l,
+                                const RHS &r) {
+    return {pred, l, r};
+}
+
+// 只有一个使用者时才匹配
+template <typename SubPattern> struct OneUseMatch {
+    SubPattern sub;
+    bool match(Value *val) {
+        return val->get_use_list().size() == 1 and sub.match(val);
+    }
+};
+template <typename SubPattern>
+OneUseMatch<SubPattern> m_OneUse(const SubPattern &p) {
+    return {p};
+}
+
+} // namespace PatternMatch
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "FuncInfo.hpp"
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+enum class AliasResult { NoAlias, MayAlias, MustAlias };
+
+/**
+ * 基本别名分析
+ * 指针被分解为 基对象 + 元素偏移，偏移形如 var + c（var 可为空）。
+ * 不同的 alloca/全局变量互不别名；同一基对象上 var 相同时按 c 判定必然/不别名；
+ * 参数指针不会指向本函数的 alloca，若所有调用点传入的都不是全局数组，
+ * 它也不会指向全局变量。
+ * 调用只能访问被调函数摘要（FuncInfo）中读写的全局变量，以及按摘要被读写的
+ * 形参对应的实参所指的内存；外部运行时函数不访问程序的内存。
+ * alias 的查询结果按函数缓存，修改了指针计算的 Pass 需要调用 invalidate
+ **/
+class AliasAnalysis : public Pass {
+  public:
+    AliasAnalysis(Module *m) : Pass(m) {}
+    void run() override;
+
+    // 默认两个指针在同一次执行中求值（如循环的同一次迭代），此时同一 SSA 下标
+    // 取值相同；across_iterations 为真时 ptr1 可能来自循环的上一次迭代，
+    // 循环中定义的基址与下标可能已经改变，只依据不同的基对象判定
+    AliasResult alias(Value *ptr1, Value *ptr2, bool across_iterations = false);
+    // 调用是否可能读写内存
+    ModRefInfo get_mod_ref_info(CallInst *call);
+    // 调用对 ptr 所指内存的影响
+    ModRefInfo get_mod_ref_info(CallInst *call, Value *ptr);
+    // 指令（load/store/call）对 ptr 所指内存的影响，其余指令不访问内存
+    ModRefInfo get_mod_ref_info(Instruction *inst, Value *ptr);
+    // 去掉 gep 后的基对象：alloca、全局变量、参数或无法分析的指针
+    static Value *get_underlying_object(Value *ptr);
+    // 对象的地址是否作为实参传给了调用
+    bool is_escaped(Value *object) { return escaped_.count(object); }
+
+    void invalidate(Function *func) { alias_cache_.erase(func); }
+
+  private:
+    // 指针 = base + var + offset，known 为假时偏移无法分析
+    struct Location {
+        Value *base;
+        Value *var;
+        int offset;
+        bool known;
+    };
+
+    std::unique_ptr<FuncInfo> func_info_;
+    // 可能指向全局变量的参数
+    std::set<Argument *> may_point_global_;
+    std::set<Value *> escaped_;
+    std::unordered_map<Function *,
+                       std::map<std::pair<Value *, Value *>, AliasResult>>
+        alias_cache_;
+
+    static Location get_location(Value *ptr);
+    static std::pair<Value *, int> decompose_index(Value *idx);
+    AliasResult alias_object(Value *base1, Value *base2);
+    AliasResult compute_alias(Value *ptr1, Value *ptr2, bool across_iterations);
+
+    void collect_escaped();
+    void compute_arg_targets();
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "AliasAnalysis.hpp"
+#include "Dominators.hpp"
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * 只读数组参数的提升
+ * 数组形参只被用于读取少数几个常量下标的元素时，改为在调用点读取这些元素，
+ * 把读到的标量作为实参传入。要求：
+ * 1. 形参只作为 load 的地址，或作为常量下标 gep 的基址且 gep 只被 load 使用；
+ * 2. 每个 load 所在块支配所有返回块，即调用返回时 load 一定已经执行，
+ *    在调用点提前读取不会引入原本不存在的访问；
+ * 3. 被调函数中没有可能写入该数组的指令（按别名分析的 mod/ref 信息），
+ *    在调用点读到的值与原来在函数中读到的值相同
+ **/
+class ArgPromotion : public Pass {
+  public:
+    ArgPromotion(Module *m) : Pass(m) {}
+    void run() override;
+
+  private:
+    // 每个形参最多提升的元素个数
+    static constexpr unsigned max_promoted_elems = 3;
+
+    // 一个可提升形参：下标到读取该元素的 load，以及需要删除的 gep
+    struct PromotedArg {
+        std::map<int, std::vector<LoadInst *>> loads;
+        std::vector<Instruction *> geps;
+    };
+
+    std::unique_ptr<AliasAnalysis> alias_analysis_;
+    std::unique_ptr<Dominators> dominators_;
+
+    bool collect_loads(Argument *arg, PromotedArg &promoted);
+    bool is_read_only(Argument *arg, const PromotedArg &promoted);
+    void promote(Function *func, std::map<unsigned, PromotedArg> &promoted);
+};
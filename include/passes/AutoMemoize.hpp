@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CallGraph.hpp"
+#include "FuncInfo.hpp"
+#include "Function.hpp"
+#include "PassManager.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * 纯递归函数的自动记忆化
+ * 参数都是 int/float 标量、返回 int/float、FuncInfo 判定为 readnone，
+ * 且函数体中至少有两处递归调用（多路递归，如 fib）的函数：
+ * 入口处以参数为键查找运行时提供的直接映射缓存（见 io.c 的 memo_*），
+ * 命中则直接返回缓存的结果，否则执行原函数体，并在每个 ret 前写入缓存。
+ * 每个函数使用一张缓存表，表数与参数个数受运行时的限制
+ **/
+class AutoMemoize : public Pass {
+  public:
+    AutoMemoize(Module *m) : Pass(m) {}
+    void run() override;
+
+  private:
+    // 与 io.c 中的 MEMO_TABLES、MEMO_MAX_KEYS 保持一致
+    static constexpr unsigned max_tables = 8;
+    static constexpr unsigned max_keys = 4;
+
+    bool is_candidate(Function *func, CallGraph &call_graph,
+                      FuncInfo &func_info);
+    void memoize(Function *func, int table);
+    // 在 bb 末尾依次传入 func 的参数作为缓存的键
+    void emit_keys(Function *func, BasicBlock *bb);
+    Function *get_runtime(const std::string &name, Type *ret_type,
+                          std::vector<Type *> params);
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <vector>
+
+/**
+ * 调用图
+ * 每个函数记录它包含的调用点、去重后的被调函数与调用者；
+ * 强连通分量由 Tarjan 算法求出，按自底向上的顺序排列（被调函数所在的分量在前），
+ * 按此顺序处理的过程间分析只需一遍即可收敛。
+ * 分析结果在 run 时计算并保存，修改了调用关系的 Pass 需要重新 run
+ **/
+class CallGraph : public Pass {
+  public:
+    using SCC = std::vector<Function *>;
+
+    explicit CallGraph(Module *m) : Pass(m) {}
+    void run() override;
+
+    const std::vector<CallInst *> &get_call_sites(Function *func) {
+        return nodes_.at(func).call_sites;
+    }
+    const std::vector<Function *> &get_callees(Function *func) {
+        return nodes_.at(func).callees;
+    }
+    const std::vector<Function *> &get_callers(Function *func) {
+        return nodes_.at(func).callers;
+    }
+
+    // 自底向上排列的强连通分量
+    const std::vector<SCC> &get_sccs() { return sccs_; }
+    unsigned get_scc_index(Function *func) { return nodes_.at(func).scc; }
+    // 直接或间接调用自身
+    bool is_recursive(Function *func);
+
+  private:
+    struct Node {
+        std::vector<CallInst *> call_sites;
+        std::vector<Function *> callees;
+        std::vector<Function *> callers;
+        unsigned scc;
+        // Tarjan 算法的访问序号与 low 值
+        int dfn{-1};
+        int low;
+        bool on_stack{false};
+    };
+
+    std::map<Function *, Node> nodes_;
+    std::vector<SCC> sccs_;
+    std::vector<Function *> stack_;
+    int dfn_count_{0};
+
+    void tarjan(Function *func);
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Instruction.hpp"
+#include "LoopDetection.hpp"
+#include "PassManager.hpp"
+
+#include <climits>
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * 负下标检查消除，要求 IR 已经过 Mem2Reg
+ * 对每个形如 br (icmp slt idx, 0), except, ok 且 except 为异常处理块的检查，
+ * 若能证明 idx 非负，则改为直接跳转到 ok，不再可达的异常块由 DeadCode 删除。
+ * idx 的取值范围由常量、循环归纳变量以及支配该检查的比较条件推出。
+ **/
+class CheckElimination : public Pass {
+  public:
+    CheckElimination(Module *m) : Pass(m) {}
+    void run() override;
+
+    // 只调用 neg_idx_except 后返回的异常处理块
+    static bool is_except_block(BasicBlock *bb);
+
+  private:
+    // 闭区间 [lo, hi]，以 64 位保存以便检测 32 位溢出
+    struct Range {
+        long long lo{INT_MIN};
+        long long hi{INT_MAX};
+    };
+
+    std::unique_ptr<LoopDetection> loop_detection_;
+    Dominators *dominators_{nullptr};
+    // phi 的范围缓存，以及缓存的插入顺序（归纳变量假设失败时回滚）
+    std::map<PhiInst *, Range> phi_range_;
+    std::vector<PhiInst *> phi_log_;
+
+    unsigned run_on_func(Function *f);
+    bool fold_check(BranchInst *br);
+
+    // val 在基本块 bb 中的取值范围
+    Range get_range(Value *val, BasicBlock *bb, unsigned depth = 0);
+    Range get_def_range(Value *val, BasicBlock *bb, unsigned depth);
+    Range get_phi_range(PhiInst *phi, unsigned depth);
+    Range get_iv_range(PhiInst *phi, Loop *loop, unsigned depth);
+    // 用支配 bb 的分支条件收紧 val 的范围
+    Range refine(Value *val, Range range, BasicBlock *bb, unsigned depth);
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Function.hpp"
+#include "Module.hpp"
+
+#include <map>
+#include <string>
+
+// 把 func 完整复制为模块中名为 name 的新函数，
+// v_map 记录原函数的参数、基本块与指令到副本的映射
+Function *clone_function(Function *func, const std::string &name,
+                         std::map<Value *, Value *> &v_map);
+
+// 把 func 的函数体复制进空函数 clone，调用前 v_map 中需已有形参的映射，
+// 未映射的形参保持原值。clone 返回 void 时，复制的 ret 丢弃返回值
+void clone_function_body(Function *func, Function *clone,
+                         std::map<Value *, Value *> &v_map);
+
+// 断开 func 的函数体对其他值的引用后，把它从模块中删除，
+// 调用前 func 不能再被其他函数使用
+void erase_function(Function *func);
@@ -1,5 +1,6 @@
 #ifndef CONSTPROPAGATION_HPP
 #define CONSTPROPAGATION_HPP
+#include "ConstFolder.hpp"
 #include "Constant.hpp"
 #include "IRBuilder.hpp"
 #include "Instruction.hpp"
@@ -13,21 +14,6 @@
 ConstantFP *cast_constantfp(Value *value);
 ConstantInt *cast_constantint(Value *value);
 
-class ConstFolder {
-public:
-    ConstFolder(Module *m) : module_(m) {}
-    // cminus only support binary operations
-    ConstantInt *compute(Instruction::OpID op, ConstantInt *value1, ConstantInt *value2);
-    ConstantFP *compute(Instruction::OpID op, ConstantFP *value1, ConstantFP *value2);
-    // int -> float
-    ConstantFP *compute(Instruction::OpID op, ConstantInt *value1);
-    // float -> int
-    ConstantInt *compute(Instruction::OpID op, ConstantFP *value1);
-
-private:
-    Module *module_;
-};
-
 class ConstPropagation : public Pass {
 public:
     ConstPropagation(Module *m) : Pass(m) {}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <vector>
+
+/**
+ * 无用参数与无用返回值消除
+ * 形参除了作为递归调用中同一位置的实参外没有其他使用时是无用的；
+ * 所有调用结果除了被本函数直接返回外没有其他使用时，返回值是无用的。
+ * 对有无用参数或返回值的内部函数（main 与外部声明除外），按新的函数类型
+ * 重建函数，并改写所有调用点
+ **/
+class DeadArgElim : public Pass {
+  public:
+    DeadArgElim(Module *m) : Pass(m) {}
+    void run() override;
+
+  private:
+    static bool is_dead_arg(Argument *arg);
+    static bool is_dead_return(Function *func);
+    void rewrite_function(Function *func, const std::vector<bool> &dead_args,
+                          bool dead_ret);
+};
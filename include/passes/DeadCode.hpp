@@ -2,27 +2,44 @@
 
 #include "FuncInfo.hpp"
 #include "PassManager.hpp"
+#include "PostDominators.hpp"
 
+#include <memory>
 #include <unordered_set>
+#include <vector>
 
 /**
  * 死代码消除：参见
  *https://www.clear.rice.edu/comp512/Lectures/10Dead-Clean-SCCP.pdf
+ * aggressive 为真时是激进模式（ADCE）：分支与 phi 不再默认有用，
+ * 有用的指令使其所在块控制依赖的分支有用，有用的 phi 使其前驱块的终结指令有用；
+ * 无用的分支改为跳转到最近的有用的后必经块。
+ * 回边上的分支与无法到达返回块的块中的分支始终有用，死循环不会被删除
  **/
 class DeadCode : public Pass {
   public:
-    DeadCode(Module *m) : Pass(m), func_info(std::make_shared<FuncInfo>(m)) {}
+    DeadCode(Module *m, bool aggressive = false)
+        : Pass(m), func_info(std::make_shared<FuncInfo>(m)),
+          aggressive_(aggressive) {}
 
     void run();
 
   private:
     std::shared_ptr<FuncInfo> func_info;
     int ins_count{0}; // 用以衡量死代码消除的性能
-    std::deque<Instruction *> work_list{};
+    std::vector<Instruction *> work_list{};
     std::unordered_map<Instruction *, bool> marked{};
 
+    bool aggressive_;
+    std::unique_ptr<PostDominators> post_dominators_;
+    // 激进模式下含有有用指令的块
+    std::unordered_set<BasicBlock *> live_bbs_;
+
     void mark(Function *func);
     void mark(Instruction *ins);
+    void mark_live(Instruction *ins);
+    void mark_loop_branches(Function *func);
+    bool rewrite_dead_branches(Function *func);
     bool sweep(Function *func);
     bool clear_basic_blocks(Function *func);
     bool is_critical(Instruction *ins);
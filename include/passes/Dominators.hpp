@@ -17,7 +17,12 @@ class Dominators : public Pass {
 
     // functions for getting information
     BasicBlock *get_idom(BasicBlock *bb) { return idom_.at(bb); }
+    // 支配边界集合在首次查询时才为所在函数计算；放置 phi 应使用 IDFCalculator，
+    // 它不需要逐块保存支配边界
     const BBSet &get_dominance_frontier(BasicBlock *bb) {
+        auto f = bb->get_parent();
+        if (frontier_ready_.insert(f).second)
+            create_dominance_frontier(f);
         return dom_frontier_.at(bb);
     }
     const BBSet &get_dom_tree_succ_blocks(BasicBlock *bb) {
@@ -34,6 +39,16 @@ class Dominators : public Pass {
                dom_tree_R_.at(bb1) >= dom_tree_L_.at(bb2);
     }
 
+    // 支配树中的深度，入口块为 0，不可达块为 -1
+    int get_dom_tree_level(BasicBlock *bb) {
+        auto iter = dom_tree_level_.find(bb);
+        return iter == dom_tree_level_.end() ? -1 : iter->second;
+    }
+    // 支配树先序遍历的序号
+    unsigned int get_dom_tree_dfs_in(BasicBlock *bb) {
+        return dom_tree_L_.at(bb);
+    }
+
     const std::vector<BasicBlock *> &get_dom_dfs_order() {
         return dom_dfs_order_;
     }
@@ -76,11 +91,13 @@ class Dominators : public Pass {
     std::map<BasicBlock *, unsigned int> post_order_{}; // 逆后序
     std::map<BasicBlock *, BasicBlock *> idom_{};  // 直接支配
     std::map<BasicBlock *, BBSet> dom_frontier_{}; // 支配边界集合
+    std::set<Function *> frontier_ready_{};         // 已计算支配边界的函数
     std::map<BasicBlock *, BBSet> dom_tree_succ_blocks_{}; // 支配树中的后继节点
 
     // 支配树上的dfs序L,R
     std::map<BasicBlock *, unsigned int> dom_tree_L_;
     std::map<BasicBlock *, unsigned int> dom_tree_R_;
+    std::map<BasicBlock *, int> dom_tree_level_;
 
     std::vector<BasicBlock *> dom_dfs_order_;
     std::vector<BasicBlock *> dom_post_order_;
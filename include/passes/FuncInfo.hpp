@@ -1,15 +1,58 @@
 #pragma once
 
+#include "CallGraph.hpp"
+#include "GlobalVariable.hpp"
 #include "PassManager.hpp"
 #include "logging.hpp"
 
-#include <deque>
+#include <set>
 #include <unordered_map>
+#include <vector>
+
+// 按位组合：Ref 表示可能读取，Mod 表示可能写入
+enum class ModRefInfo { NoModRef = 0, Ref = 1, Mod = 2, ModRef = 3 };
+
+inline bool is_mod(ModRefInfo info) {
+    return static_cast<int>(info) & static_cast<int>(ModRefInfo::Mod);
+}
+inline bool is_ref(ModRefInfo info) {
+    return static_cast<int>(info) & static_cast<int>(ModRefInfo::Ref);
+}
+inline ModRefInfo union_mod_ref(ModRefInfo a, ModRefInfo b) {
+    return static_cast<ModRefInfo>(static_cast<int>(a) | static_cast<int>(b));
+}
+
+// 函数（含其直接、间接调用的函数）对非局部内存的访问摘要
+struct FuncSummary {
+    std::set<GlobalVariable *> ref_globals;
+    std::set<GlobalVariable *> mod_globals;
+    // 每个形参所指内存的读写情况，标量形参总是 NoModRef
+    std::vector<ModRefInfo> arg_mod_ref;
+    // 调用了外部运行时函数（输入输出）
+    bool has_io{false};
+    // 可能不返回，例如经 neg_idx_except 退出程序
+    bool may_not_return{false};
+
+    bool operator==(const FuncSummary &other) const {
+        return ref_globals == other.ref_globals and
+               mod_globals == other.mod_globals and
+               arg_mod_ref == other.arg_mod_ref and
+               has_io == other.has_io and
+               may_not_return == other.may_not_return;
+    }
+    bool operator!=(const FuncSummary &other) const {
+        return not(*this == other);
+    }
+};
 
 /**
- * 计算哪些函数是纯函数
- * WARN:
- * 假定所有函数都是纯函数，除非他写入了全局变量、修改了传入的数组、或者直接间接调用了非纯函数
+ * 计算每个函数的读写摘要：读写了哪些全局变量、每个指针形参所指的内存是
+ * 只读、只写、读写还是未访问、是否有输入输出、是否可能不返回。
+ * 局部 alloca 的读写不计入；基址无法确定的访问视为访问所有指针形参。
+ * 调用把被调函数的摘要并入调用者，形参的读写映射到对应实参的基对象上。
+ * 外部声明的运行时函数视为有输入输出且可能不返回；与原先一致，
+ * 假定循环与递归总会终止。
+ * 按调用图的强连通分量自底向上处理，分量内迭代到不动点
  */
 class FuncInfo : public Pass {
   public:
@@ -17,19 +60,22 @@ class FuncInfo : public Pass {
 
     void run();
 
-    bool is_pure_function(Function *func) const { return is_pure.at(func); }
+    const FuncSummary &get_summary(Function *func) const {
+        return summaries_.at(func);
+    }
+    // 不写非局部内存、没有输入输出且总会返回：结果未被使用的调用可以删除
+    bool is_readonly(Function *func) const;
+    // 在 readonly 的基础上也不读非局部内存：调用结果只取决于实参
+    bool is_readnone(Function *func) const;
 
   private:
-    std::deque<Function *> worklist;
-    std::unordered_map<Function *, bool> is_pure;
+    std::unordered_map<Function *, FuncSummary> summaries_;
 
-    void trivial_mark(Function *func);
-    void process(Function *func);
+    void process(CallGraph &call_graph, const CallGraph::SCC &scc);
+    bool update(Function *func);
+    void add_access(FuncSummary &summary, Function *func, Value *ptr,
+                    ModRefInfo info);
     Value *get_first_addr(Value *val);
 
-    bool is_side_effect_inst(Instruction *inst);
-    bool is_local_load(LoadInst *inst);
-    bool is_local_store(StoreInst *inst);
-
     void log();
 };
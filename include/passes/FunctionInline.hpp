@@ -1,21 +1,49 @@
 #pragma once
 
+#include "CallGraph.hpp"
+#include "LoopDetection.hpp"
 #include "PassManager.hpp"
 
+#include <map>
+#include <vector>
 
-class FunctionInline : public Pass{
-public:
+/**
+ * 函数内联：按调用图的强连通分量自底向上处理，被调函数先完成内联。
+ * 每个调用点按被调函数的指令代价与阈值比较，实参为常量、调用点位于循环中时
+ * 放宽阈值；每个调用者的代价增长不超过预算。
+ * 调用点放在工作表中，内联引入的新调用点继续加入工作表，而不是重新扫描整个函数
+ **/
+class FunctionInline : public Pass {
+  public:
     FunctionInline(Module *m) : Pass(m) {}
 
     void run();
 
-    void inline_function(Instruction *dest, Function *func);
+    // 返回复制进调用者的调用指令
+    std::vector<CallInst *> inline_function(Instruction *dest, Function *func);
 
     void inline_all_functions();
 
-    // void log();
-    std::set<std::string> outside_func={"output",
-                                        "outputFloat",
-                                        "input",
-                                        "neg_idx_except"};
-};
\ No newline at end of file
+  private:
+    // 被调函数代价不超过该值时内联
+    static constexpr int inline_threshold = 45;
+    // 每个常量实参放宽的阈值
+    static constexpr int const_arg_bonus = 15;
+    // 调用点位于循环中时放宽的阈值
+    static constexpr int loop_bonus = 40;
+    // 调用者至少可以增长的代价
+    static constexpr int min_growth_budget = 200;
+
+    struct CallSite {
+        CallInst *call;
+        bool in_loop;
+    };
+
+    std::map<Function *, int> cost_;
+
+    static int get_inst_cost(Instruction *inst);
+    static int compute_cost(Function *func);
+    int get_threshold(const CallSite &site);
+    void inline_into(Function *caller, CallGraph &call_graph,
+                     LoopDetection &loop_detection);
+};
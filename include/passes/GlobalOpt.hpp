@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <set>
+#include <vector>
+
+/**
+ * 全局变量优化：
+ * 从未被写入的全局变量（含只读的数组）的读取替换为初始值；
+ * 从未被读取的全局变量删除其全部写入；
+ * 只在 main 中使用的标量全局变量改为 main 入口处的 alloca 并写入初始值，交由 Mem2Reg 提升。
+ * 地址被传给函数或存入内存的全局变量不做处理，无用的全局变量由 DeadCode 删除
+ **/
+class GlobalOpt : public Pass {
+  public:
+    GlobalOpt(Module *m) : Pass(m) {}
+    void run() override;
+
+  private:
+    // 全局变量经由 gep 的全部访问
+    struct Usage {
+        std::vector<LoadInst *> loads;
+        std::vector<StoreInst *> stores;
+        std::set<Function *> funcs;
+        bool escaped{false};
+    };
+
+    void analyze(Value *ptr, Usage &usage);
+    // 全局变量初始值中 load 所读取的常量，无法确定时返回 nullptr
+    Value *get_init_value(GlobalVariable *global, Type *ty);
+    void localize(GlobalVariable *global, Function *main_func);
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Dominators.hpp"
+
+#include <set>
+#include <vector>
+
+/**
+ * 迭代支配边界计算（Sreedhar-Gao DJ 图算法）
+ * 不依赖逐块保存的支配边界，而是在支配树（D 边）与 CFG 中非支配树边（J 边）上
+ * 按支配树深度从深到浅处理定值块：从根 r 出发遍历其支配子树，
+ * 目标深度不超过 r 的 J 边指向的块即属于迭代支配边界。
+ * 给定活跃入口块集合时只返回其中的块，用于剪枝 SSA
+ **/
+class IDFCalculator {
+  public:
+    // dominators 需已在所在函数上完成分析
+    explicit IDFCalculator(Dominators *dominators) : dominators_(dominators) {}
+
+    void set_def_blocks(const std::set<BasicBlock *> &blocks) {
+        def_blocks_ = &blocks;
+    }
+    void set_live_in_blocks(const std::set<BasicBlock *> &blocks) {
+        live_in_blocks_ = &blocks;
+    }
+    void reset_live_in_blocks() { live_in_blocks_ = nullptr; }
+
+    // 计算定值块集合的迭代支配边界
+    void calculate(std::vector<BasicBlock *> &idf_blocks);
+
+  private:
+    Dominators *dominators_;
+    const std::set<BasicBlock *> *def_blocks_{nullptr};
+    const std::set<BasicBlock *> *live_in_blocks_{nullptr};
+};
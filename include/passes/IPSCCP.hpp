@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ConstFolder.hpp"
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "LoopDetection.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+/**
+ * 过程间稀疏条件常量传播
+ * 格值为 未定 > 常量 > 非常量。从 main 的入口出发，只有可达的边与基本块参与求值；
+ * 调用点把实参的格值并入形参，被调函数返回值的格值作为调用结果。
+ * 求解后，把常量替换到所有使用处，并把条件为常量的分支改为无条件跳转。
+ * 函数特化：形参不是常量、但某组调用点（至少两个，或位于循环中）传入相同常量的
+ * 函数被复制为 <name>_spec<k>，副本中的形参替换为常量，该组调用改为调用副本，
+ * 然后重新求解。复制数量受总预算、每函数预算与函数大小限制
+ **/
+class IPSCCP : public Pass {
+  public:
+    IPSCCP(Module *m) : Pass(m), folder_(m) {}
+    void run() override;
+
+  private:
+    struct LatticeVal {
+        enum State { Undef, Const, Overdefined } state{Undef};
+        Constant *val{nullptr};
+
+        bool operator==(const LatticeVal &other) const {
+            return state == other.state and val == other.val;
+        }
+        bool operator!=(const LatticeVal &other) const {
+            return not(*this == other);
+        }
+    };
+
+    static constexpr unsigned max_clones = 8;
+    static constexpr unsigned max_clones_per_func = 2;
+    static constexpr unsigned max_clone_size = 150;
+
+    ConstFolder folder_;
+    std::map<Value *, LatticeVal> values_;
+    std::map<Function *, LatticeVal> returns_;
+    std::set<BasicBlock *> executable_;
+    std::set<std::pair<BasicBlock *, BasicBlock *>> executable_edges_;
+    std::vector<BasicBlock *> block_work_list_;
+    std::vector<Instruction *> inst_work_list_;
+
+    static LatticeVal meet(const LatticeVal &a, const LatticeVal &b);
+    LatticeVal get_value(Value *val);
+    // 把 new_val 并入 val 的格值，变化时重新求值它的使用者
+    void merge(Value *val, const LatticeVal &new_val);
+    void merge_return(Function *func, const LatticeVal &new_val);
+    void mark_block(BasicBlock *bb);
+    void mark_edge(BasicBlock *from, BasicBlock *to);
+
+    void visit(Instruction *inst);
+    void visit_phi(PhiInst *phi);
+    void visit_branch(BranchInst *br);
+    void visit_call(CallInst *call);
+    void visit_fold(Instruction *inst);
+
+    void solve();
+    bool specialize();
+    void rewrite();
+    void erase_dead_blocks(Function *func);
+};
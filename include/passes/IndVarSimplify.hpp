@@ -0,0 +1,68 @@
+#pragma once
+
+#include "IRBuilder.hpp"
+#include "Instruction.hpp"
+#include "LoopDetection.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+/**
+ * 归纳变量化简与强度削弱，要求 IR 已经过 Mem2Reg：
+ * 1. 识别 header 中形如 i = phi [init, preheader], [i +/- c, latch] 的基本归纳变量
+ * 2. 步长相同的基本归纳变量改写为同一个规范归纳变量加上偏移
+ * 3. 由 +、-、* 常数构成的 i * k + c 形式的派生归纳变量按仿射式识别，
+ *    其上的乘法改写为加法递推，同一 i * k 的派生归纳变量共用一个递推再加上偏移
+ * 4. 以仿射式为下标的 getelementptr 改写为指针递推，常数偏移不同的下标共用一个指针
+ * 5. 规范化退出条件：归纳变量放在左侧，<=、>= 改写为 <、>
+ **/
+class IndVarSimplify : public Pass {
+  public:
+    IndVarSimplify(Module *m) : Pass(m), builder_(nullptr, m, true) {}
+    void run() override;
+
+  private:
+    struct InductionVar {
+        PhiInst *phi;
+        Value *init; // 进入循环时的初值
+        Value *step; // 每次迭代的增量，常量或循环不变量
+    };
+
+    // val = iv * scale + var * var_coef + offset，var 为循环不变量
+    struct Affine {
+        InductionVar iv;
+        int scale;
+        Value *var;
+        int var_coef;
+        int offset;
+    };
+
+    std::unique_ptr<LoopDetection> loop_detection_;
+    // 折叠模式，在指定的指令之前生成新指令
+    IRBuilder builder_;
+    Loop *loop_{nullptr};
+    BasicBlock *preheader_{nullptr};
+    BasicBlock *latch_{nullptr};
+    std::vector<InductionVar> ivs_;
+    // reduce_multiplies 生成的递推，以常数倍数表示为基本归纳变量的仿射式
+    std::map<PhiInst *, Affine> derived_;
+
+    void run_on_loop(Loop *loop);
+    void find_basic_ivs();
+    const InductionVar *get_iv(Value *val) const;
+    bool get_affine(Value *val, Affine &affine, unsigned depth = 0);
+    // affine 加上 sign * val，val 为常数或循环不变量
+    bool add_invariant(Affine &affine, Value *val, int sign);
+    // 在 preheader 末尾生成 var * coef + offset
+    Value *emit_invariant(Value *var, int coef, int offset);
+    // 删除循环中不再被使用的运算，并继续检查其操作数
+    void erase_dead(Instruction *inst, std::set<Instruction *> &erased);
+
+    bool eliminate_redundant_ivs();
+    bool reduce_multiplies();
+    bool reduce_geps();
+    bool canonicalize_exit_conditions();
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ConstFolder.hpp"
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <deque>
+#include <unordered_set>
+
+/**
+ * 代数化简与窥孔优化，基于 PatternMatch 以工作表迭代到不动点：
+ * 常量折叠、x+0、x*1、x*0、x-x、双重取负、常量移到右侧、
+ * zext 后再比较的折叠、sitofp/fptosi 往返消除等
+ **/
+class InstCombine : public Pass {
+  public:
+    InstCombine(Module *m) : Pass(m), folder_(m) {}
+    void run() override;
+
+  private:
+    ConstFolder folder_;
+    std::deque<Instruction *> work_list_;
+    std::unordered_set<Instruction *> in_work_list_;
+    int combine_count_{0};
+
+    void push(Value *val);
+    void push_users(Value *val);
+    void erase(Instruction *inst);
+
+    // 返回用以替换 inst 的值；原地修改 inst 时返回 inst；无法化简时返回 nullptr
+    Value *simplify(Instruction *inst);
+    Value *simplify_int_binary(Instruction *inst);
+    Value *simplify_float_binary(Instruction *inst);
+    Value *simplify_icmp(Instruction *inst);
+    Value *simplify_fcmp(Instruction *inst);
+    Value *simplify_cast(Instruction *inst);
+};
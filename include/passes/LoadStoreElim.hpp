@@ -0,0 +1,34 @@
+#pragma once
+
+#include "AliasAnalysis.hpp"
+#include "Dominators.hpp"
+#include "Instruction.hpp"
+#include "MemorySSA.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * 冗余 load 消除与死 store 消除
+ * 地址间的关系与调用的读写效果由 AliasAnalysis 给出。
+ * load 转发借助 MemorySSA 找到最近可能写入其地址的访问：它是同地址的 store 时
+ * 使用存入的值，否则复用最近写入者相同且支配它的同地址 load；
+ * 死 store 消除在基本块内进行，另外删除对从未被读取的局部数组/变量的写入
+ **/
+class LoadStoreElim : public Pass {
+  public:
+    LoadStoreElim(Module *m) : Pass(m) {}
+    void run() override;
+
+  private:
+    std::unique_ptr<AliasAnalysis> alias_analysis_;
+    std::unique_ptr<Dominators> dominators_;
+    unsigned load_count_{0};
+    unsigned store_count_{0};
+
+    void forward_loads(Function *func);
+    void eliminate_dead_stores(BasicBlock *bb);
+    void eliminate_unread_stores(Function *func);
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Dominators.hpp"
+#include "Function.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+/**
+ * 自然循环：由回边 latch->header 确定，header 支配循环中的所有基本块
+ **/
+class Loop {
+  public:
+    using BBSet = std::set<BasicBlock *>;
+
+    explicit Loop(BasicBlock *header) : header_(header) {
+        blocks_.insert(header);
+    }
+
+    BasicBlock *get_header() const { return header_; }
+    const BBSet &get_blocks() const { return blocks_; }
+    const std::vector<BasicBlock *> &get_latches() const { return latches_; }
+    Loop *get_parent() const { return parent_; }
+    const std::vector<Loop *> &get_sub_loops() const { return sub_loops_; }
+
+    bool contains(BasicBlock *bb) const { return blocks_.count(bb) != 0; }
+    bool contains(Loop *loop) const;
+    unsigned get_depth() const { return parent_ ? parent_->get_depth() + 1 : 1; }
+
+    // 唯一的循环外前驱，且它只有 header 一个后继；不存在时返回 nullptr
+    BasicBlock *get_preheader() const;
+    // 唯一的回边来源；存在多个回边时返回 nullptr
+    BasicBlock *get_single_latch() const {
+        return latches_.size() == 1 ? latches_.front() : nullptr;
+    }
+    // 循环外的后继基本块（不重复）
+    std::vector<BasicBlock *> get_exit_blocks() const;
+    // 有边离开循环的循环内基本块
+    std::vector<BasicBlock *> get_exiting_blocks() const;
+    // 若 val 定义在循环之外（常量、参数或循环外指令）则为循环不变量
+    bool is_invariant(Value *val) const;
+
+  private:
+    friend class LoopDetection;
+
+    BasicBlock *header_;
+    BBSet blocks_;
+    std::vector<BasicBlock *> latches_;
+    Loop *parent_{nullptr};
+    std::vector<Loop *> sub_loops_;
+};
+
+class LoopDetection : public Pass {
+  public:
+    explicit LoopDetection(Module *m) : Pass(m) {}
+    ~LoopDetection() = default;
+
+    void run() override;
+    void run_on_func(Function *f);
+
+    // 函数中的全部循环，内层循环排在外层循环之前
+    const std::vector<Loop *> &get_loops(Function *f) { return loops_[f]; }
+    // bb 所在的最内层循环，不在循环中时返回 nullptr
+    Loop *get_loop_of(BasicBlock *bb) const {
+        auto it = bb_to_loop_.find(bb);
+        return it == bb_to_loop_.end() ? nullptr : it->second;
+    }
+    unsigned get_loop_depth(BasicBlock *bb) const {
+        auto loop = get_loop_of(bb);
+        return loop ? loop->get_depth() : 0;
+    }
+    Dominators *get_dominators() { return dominators_.get(); }
+
+    void print();
+
+  private:
+    void discover_loop(Loop *loop, BasicBlock *latch);
+
+    std::unique_ptr<Dominators> dominators_;
+    std::vector<std::unique_ptr<Loop>> loop_pool_;
+    std::map<Function *, std::vector<Loop *>> loops_;
+    std::map<BasicBlock *, Loop *> bb_to_loop_;
+};
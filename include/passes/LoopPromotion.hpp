@@ -0,0 +1,28 @@
+#pragma once
+
+#include "FuncInfo.hpp"
+#include "LoopDetection.hpp"
+#include "PassManager.hpp"
+
+#include <memory>
+
+/**
+ * 循环中全局标量的寄存器提升
+ * 循环内不调用非纯函数时，全局标量只会被循环内的 load/store 访问：
+ * 在 preheader 中读取一次存入新的局部变量，循环内改为访问该局部变量，
+ * 循环中有写入时在各退出块开头写回全局变量，最后由 Mem2Reg 插入 phi 提升为 SSA 值。
+ * 要求各退出块的前驱都在循环内
+ **/
+class LoopPromotion : public Pass {
+  public:
+    LoopPromotion(Module *m) : Pass(m) {}
+    void run() override;
+
+  private:
+    std::unique_ptr<FuncInfo> func_info_;
+
+    bool run_on_loop(Loop *loop);
+    bool has_unknown_call(Loop *loop);
+    void promote(Loop *loop, GlobalVariable *global,
+                 const std::vector<Instruction *> &accesses, bool has_store);
+};
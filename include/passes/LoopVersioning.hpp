@@ -0,0 +1,49 @@
+#pragma once
+
+#include "IRBuilder.hpp"
+#include "Instruction.hpp"
+#include "LoopDetection.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * 循环版本化，要求 IR 已经过 Mem2Reg
+ * 对最内层循环中下标为归纳变量仿射函数 scale * iv + offset 的负下标检查，
+ * 在 preheader 中根据归纳变量的初值与退出界限一次性判断全部下标非负：
+ * 成立时进入去掉这些检查的循环副本，否则进入原循环。
+ * 为保证运行时判断中不发生溢出，要求各端点的绝对值不超过 LIMIT。
+ **/
+class LoopVersioning : public Pass {
+  public:
+    LoopVersioning(Module *m) : Pass(m), builder_(nullptr, m, true) {}
+    void run() override;
+
+  private:
+    static constexpr int LIMIT = 1 << 20;
+    static constexpr int MAX_SCALE = 1 << 10;
+
+    // 下标 = scale * iv + offset
+    struct Check {
+        BranchInst *br;
+        long long scale;
+        Value *offset;
+    };
+
+    std::unique_ptr<LoopDetection> loop_detection_;
+    // 折叠模式，在 preheader 的终结指令前生成运行时判断
+    IRBuilder builder_;
+    Loop *loop_{nullptr};
+    BasicBlock *preheader_{nullptr};
+    PhiInst *iv_{nullptr};
+
+    bool run_on_loop(Loop *loop);
+    bool get_affine(Value *val, long long &scale, Value *&offset);
+    // 生成运行时判断并返回 i1 结果，first、last 为 iv 在循环体中取值的两个端点
+    Value *create_guard(Value *first, Value *last, long long step,
+                        const std::vector<Check> &checks);
+    void clone_loop(BasicBlock *exit_bb, BasicBlock *fast_entry,
+                    BasicBlock *slow_entry, const std::vector<Check> &checks);
+};
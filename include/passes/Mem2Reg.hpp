@@ -6,18 +6,32 @@
 
 #include <map>
 #include <memory>
-
+#include <set>
+#include <vector>
+
+/**
+ * 将只被 load/store 直接访问的标量 alloca 提升为 SSA 值
+ * phi 只放置在变量活跃的迭代支配边界上（剪枝 SSA），重命名沿 CFG 以显式工作表进行，
+ * 变量按稠密下标编号；未赋值的变量取零值，最后删除平凡的 phi
+ **/
 class Mem2Reg : public Pass {
   private:
     Function *func_;
     std::unique_ptr<Dominators> dominators_;
-    std::map<Value *, Value *> phi_map;
-    // TODO 添加需要的变量
 
-    // 变量定值栈
-    std::map<Value *, std::vector<Value *>> var_val_stack;
-    // phi指令对应的左值(地址)
-    std::map<PhiInst *, Value *> phi_lval;
+    // 可提升的 alloca，下标即变量编号
+    std::vector<AllocaInst *> allocas_;
+    std::map<Value *, unsigned> var_index_;
+    // 本 Pass 插入的 phi 对应的变量编号
+    std::map<PhiInst *, unsigned> phi_var_;
+    std::set<BasicBlock *> visited_;
+
+    // 沿 CFG 边 pred -> bb 传递的各变量当前定值
+    struct RenameState {
+        BasicBlock *bb;
+        BasicBlock *pred;
+        std::vector<Value *> values;
+    };
 
   public:
     Mem2Reg(Module *m) : Pass(m) {}
@@ -25,17 +39,16 @@ class Mem2Reg : public Pass {
 
     void run() override;
 
+    void collect_allocas();
     void generate_phi();
-    void rename(BasicBlock *bb);
-
-    static inline bool is_global_variable(Value *l_val) {
-        return dynamic_cast<GlobalVariable *>(l_val) != nullptr;
-    }
-    static inline bool is_gep_instr(Value *l_val) {
-        return dynamic_cast<GetElementPtrInst *>(l_val) != nullptr;
-    }
-
-    static inline bool is_valid_ptr(Value *l_val) {
-        return not is_global_variable(l_val) and not is_gep_instr(l_val);
+    void rename();
+    void remove_trivial_phi();
+
+    // alloca 只作为 load 的地址或 store 的地址使用时才可以提升
+    static bool is_promotable(AllocaInst *alloca);
+    Value *get_zero(Type *ty);
+    int get_index(Value *ptr) {
+        auto iter = var_index_.find(ptr);
+        return iter == var_index_.end() ? -1 : static_cast<int>(iter->second);
     }
 };
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "AliasAnalysis.hpp"
+#include "Dominators.hpp"
+#include "Instruction.hpp"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+/**
+ * 内存访问节点：把整个内存看作一个变量，MemoryDef 是它的定值，
+ * MemoryUse 是它的使用，MemoryPhi 在汇合点合并定值
+ **/
+class MemoryAccess {
+  public:
+    enum Kind { Def, Use, Phi };
+
+    MemoryAccess(Kind kind, BasicBlock *bb, unsigned id)
+        : kind_(kind), bb_(bb), id_(id) {}
+    virtual ~MemoryAccess() = default;
+
+    Kind get_kind() const { return kind_; }
+    bool is_def() const { return kind_ == Def; }
+    bool is_use() const { return kind_ == Use; }
+    bool is_phi() const { return kind_ == Phi; }
+    BasicBlock *get_block() const { return bb_; }
+    unsigned get_id() const { return id_; }
+    const std::set<MemoryAccess *> &get_users() const { return users_; }
+
+  private:
+    friend class MemorySSA;
+    Kind kind_;
+    BasicBlock *bb_;
+    unsigned id_;
+    std::set<MemoryAccess *> users_;
+};
+
+// store 或会读写内存的调用；inst 为空的 MemoryDef 表示函数入口时的内存状态
+class MemoryDef : public MemoryAccess {
+  public:
+    MemoryDef(Instruction *inst, BasicBlock *bb, unsigned id)
+        : MemoryAccess(Def, bb, id), inst_(inst) {}
+    Instruction *get_instruction() const { return inst_; }
+    MemoryAccess *get_defining_access() const { return defining_; }
+
+  private:
+    friend class MemorySSA;
+    Instruction *inst_;
+    MemoryAccess *defining_{nullptr};
+};
+
+// load
+class MemoryUse : public MemoryAccess {
+  public:
+    MemoryUse(Instruction *inst, BasicBlock *bb, unsigned id)
+        : MemoryAccess(Use, bb, id), inst_(inst) {}
+    Instruction *get_instruction() const { return inst_; }
+    MemoryAccess *get_defining_access() const { return defining_; }
+
+  private:
+    friend class MemorySSA;
+    Instruction *inst_;
+    MemoryAccess *defining_{nullptr};
+};
+
+class MemoryPhi : public MemoryAccess {
+  public:
+    MemoryPhi(BasicBlock *bb, unsigned id) : MemoryAccess(Phi, bb, id) {}
+    const std::vector<std::pair<MemoryAccess *, BasicBlock *>> &
+    get_incoming() const {
+        return incoming_;
+    }
+
+  private:
+    friend class MemorySSA;
+    std::vector<std::pair<MemoryAccess *, BasicBlock *>> incoming_;
+};
+
+/**
+ * 函数级的 Memory SSA
+ * MemoryPhi 放置在定值块的迭代支配边界上，沿支配树重命名得到每个访问的
+ * 直接定值（defining access）。get_clobbering_access 从 load 的直接定值出发，
+ * 借助别名分析跳过不会写入其地址的 MemoryDef，
+ * 遇到 MemoryPhi 时若所有入边（忽略回到自身的环）都归结到同一个支配它的访问，
+ * 就继续越过它，否则返回该 MemoryPhi。查询结果会被缓存
+ **/
+class MemorySSA {
+  public:
+    // dominators 需已完成分析
+    MemorySSA(Function *func, AliasAnalysis *alias_analysis,
+              Dominators *dominators);
+
+    MemoryAccess *get_memory_access(Instruction *inst) {
+        auto iter = accesses_.find(inst);
+        return iter == accesses_.end() ? nullptr : iter->second;
+    }
+    MemoryPhi *get_memory_phi(BasicBlock *bb) {
+        auto iter = phis_.find(bb);
+        return iter == phis_.end() ? nullptr : iter->second;
+    }
+    MemoryDef *get_live_on_entry() { return live_on_entry_; }
+    bool is_live_on_entry(MemoryAccess *access) {
+        return access == live_on_entry_;
+    }
+
+    // 最近一个可能写入 load 地址的访问
+    MemoryAccess *get_clobbering_access(LoadInst *load);
+    // 从 start 出发，最近一个可能写入 ptr 的访问
+    MemoryAccess *get_clobbering_access(MemoryAccess *start, Value *ptr);
+
+    // 指令被删除前调用，使用它的访问改为使用它的直接定值
+    void remove_access(Instruction *inst);
+
+  private:
+    Function *func_;
+    AliasAnalysis *alias_analysis_;
+    Dominators *dominators_;
+
+    std::vector<std::unique_ptr<MemoryAccess>> storage_;
+    std::map<Instruction *, MemoryAccess *> accesses_;
+    std::map<BasicBlock *, MemoryPhi *> phis_;
+    MemoryDef *live_on_entry_;
+    std::map<LoadInst *, MemoryAccess *> clobber_cache_;
+
+    // 单次查询中已经归结的 MemoryPhi，与正在归结的 MemoryPhi；
+    // across_iterations 表示已沿回边进入循环的上一次迭代，
+    // 归结结果与之相关，因此按 (phi, across_iterations) 记录
+    struct WalkState {
+        Value *ptr;
+        std::map<std::pair<MemoryPhi *, bool>, MemoryAccess *> resolved;
+        std::set<MemoryPhi *> visiting;
+        bool across_iterations{false};
+    };
+
+    template <typename T, typename... Args> T *create(Args &&...args);
+    void build();
+    bool is_clobbered_by(MemoryDef *def, const WalkState &state);
+    bool dominates(MemoryAccess *access, BasicBlock *bb);
+    MemoryAccess *walk(MemoryAccess *start, WalkState &state);
+    MemoryAccess *resolve_phi(MemoryPhi *phi, WalkState &state);
+};
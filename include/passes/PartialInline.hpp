@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <vector>
+
+/**
+ * 部分内联：函数入口块只做少量标量计算后条件跳转，其中一侧直接返回参数或常量时
+ * （如 if (v == 0) return u;），把去掉该判断的函数体复制为 <name>_cold，
+ * 并在每个调用点展开入口判断：满足条件时直接得到返回值，否则调用 <name>_cold。
+ * 递归函数自身中的调用点同样被展开，原函数随后由 DeadCode 删除
+ **/
+class PartialInline : public Pass {
+  public:
+    PartialInline(Module *m) : Pass(m) {}
+    void run() override;
+
+  private:
+    // 入口判断中标量计算指令数的上限
+    static constexpr unsigned max_guard_size = 4;
+
+    struct Guard {
+        // 条件为真时直接返回
+        bool return_on_true;
+        // 直接返回的值，void 函数为空
+        Value *ret_val;
+    };
+
+    bool match_guard(Function *func, Guard &guard);
+    Function *create_cold_function(Function *func, const Guard &guard);
+    void expand_call(CallInst *call, Function *func, Function *cold,
+                     const Guard &guard);
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "BasicBlock.hpp"
+#include "PassManager.hpp"
+
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * 后必经关系分析，即逆 CFG 上的支配树
+ * 所有返回块都连向一个虚拟出口，它是后必经树的根，在接口中用 nullptr 表示。
+ * 无法到达返回块的块（死循环）按函数中的顺序选取一个连向虚拟出口，直到所有块
+ * 都能到达出口。逆支配边界即控制依赖：bb 控制依赖于其逆支配边界中各块的终结指令。
+ * 算法与 Dominators 相同（Cooper-Harvey-Kennedy），在逆 CFG 的后序上迭代
+ **/
+class PostDominators : public Pass {
+  public:
+    using BBSet = std::set<BasicBlock *>;
+
+    explicit PostDominators(Module *m) : Pass(m) {}
+    void run() override;
+    void run_on_func(Function *f);
+
+    // 直接后必经块，nullptr 表示虚拟出口
+    BasicBlock *get_ipdom(BasicBlock *bb) { return ipdom_.at(bb); }
+    // bb1 是否后必经 bb2，bb1 为 nullptr（虚拟出口）时总是成立
+    bool is_post_dominate(BasicBlock *bb1, BasicBlock *bb2);
+    // bb 控制依赖的块
+    const BBSet &get_reverse_dominance_frontier(BasicBlock *bb) {
+        return reverse_frontier_.at(bb);
+    }
+    // bb 是否能到达某个返回块
+    bool reaches_return(BasicBlock *bb) { return reaches_return_.count(bb); }
+
+  private:
+    std::map<BasicBlock *, BasicBlock *> ipdom_;
+    std::map<BasicBlock *, BBSet> reverse_frontier_;
+    std::set<BasicBlock *> reaches_return_;
+    // 逆 CFG 上的后序编号，虚拟出口的编号最大
+    std::map<BasicBlock *, unsigned> post_order_;
+    std::vector<BasicBlock *> post_order_vec_;
+    // 连向虚拟出口的块
+    std::set<BasicBlock *> exit_preds_;
+
+    void dfs(BasicBlock *bb, std::set<BasicBlock *> &visited);
+    void create_post_order(Function *f);
+    void create_ipdom();
+    void create_reverse_frontier(Function *f);
+    BasicBlock *intersect(BasicBlock *b1, BasicBlock *b2);
+    // 逆 CFG 上 bb 的前驱，即 CFG 上的后继，虚拟出口记为 nullptr
+    std::vector<BasicBlock *> get_reverse_preds(BasicBlock *bb);
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+/**
+ * 局部数组的标量替换
+ * 只以常量下标访问、地址不外泄的局部数组，拆分为每个元素一个标量 alloca，
+ * 之后由 Mem2Reg 提升为 SSA 值
+ **/
+class SROA : public Pass {
+  public:
+    SROA(Module *m) : Pass(m) {}
+    void run() override;
+
+  private:
+    bool can_split(AllocaInst *alloca);
+    void split(AllocaInst *alloca);
+};
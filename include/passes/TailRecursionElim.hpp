@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Function.hpp"
+#include "Instruction.hpp"
+#include "PassManager.hpp"
+
+#include <vector>
+
+/**
+ * 尾递归消除：把对自身的尾调用改为跳回函数开头的循环，每个参数对应循环头的一个 phi。
+ * 尾调用指调用的结果直接返回（或经只含 phi 与 ret 的返回块返回），
+ * 无返回值的调用之后直接返回或跳转到只含 ret void 的返回块；
+ * 返回值为 f(...) + x 或 f(...) * x 时引入累加器，递归出口的返回值与累加器合并。
+ * 局部数组作为实参传给递归调用时不做变换，因为各层递归的数组会共用同一块栈空间
+ **/
+class TailRecursionElim : public Pass {
+  public:
+    TailRecursionElim(Module *m) : Pass(m) {}
+    void run() override;
+
+  private:
+    struct TailSite {
+        CallInst *call;
+        // 累加形式中合并调用结果的指令，普通尾调用为空
+        Instruction *acc_inst;
+        // 经返回块返回时指向该块，否则为空
+        BasicBlock *ret_bb;
+    };
+
+    bool match_tail_site(Function *func, CallInst *call, TailSite &site);
+    // 指令之后的下一条指令是否直接返回 val，val 为空表示无返回值
+    bool returns_directly(Instruction *inst, Value *val,
+                          BasicBlock *&ret_bb);
+    bool has_escaping_alloca(Function *func, const std::vector<TailSite> &sites);
+    void eliminate(Function *func, const std::vector<TailSite> &sites,
+                   Instruction::OpID acc_op);
+};
@@ -79,7 +79,7 @@ Value* CminusfBuilder::visit(ASTVarDeclaration &node) {
     else {
         // 局部作用域
         if(node.num==nullptr) {
-            auto gen_var = builder->create_alloca(var_type); // 局部变量分配：分配栈上空间
+            auto gen_var = create_variable(var_type, node.id); // 局部标量变量
             scope.push(node.id, gen_var);   // 将变量加入局部作用域
         }
         else {
@@ -127,6 +127,7 @@ Value* CminusfBuilder::visit(ASTFunDeclaration &node) {
     context.func = func;                    // 设置当前函数上下文
     auto funBB = BasicBlock::create(module.get(), "entry", func); // 创建函数入口基本块
     builder->set_insert_point(funBB);       // 设置 IR 插入点
+    seal_block(funBB);                      // 入口块没有前驱
     scope.enter();                          // 进入新的作用域
 
     // 处理函数参数：为每个参数分配存储空间
@@ -134,33 +135,11 @@ Value* CminusfBuilder::visit(ASTFunDeclaration &node) {
     for (auto &arg : func->get_args()) {
         args.push_back(&arg);               // 收集函数参数
     }
-    Value* var_alloca;
     for (int i = 0; i < node.params.size(); ++i) {
         auto param = node.params[i];
-        if (param->type==TYPE_INT) {
-            if (param->isarray) {
-                var_alloca = builder->create_alloca(INT32PTR_T); // 为整数数组参数分配指针空间
-                builder->create_store(args[i], var_alloca); // 存储参数值
-                scope.push(param->id, var_alloca); // 加入作用域
-            }
-            else {
-                var_alloca = builder->create_alloca(INT32_T); // 为整数参数分配空间
-                builder->create_store(args[i], var_alloca); // 存储参数值
-                scope.push(param->id, var_alloca); // 加入作用域
-            }
-        }
-        else {
-            if (param->isarray) {
-                var_alloca = builder->create_alloca(FLOATPTR_T); // 为浮点数数组参数分配指针空间
-                builder->create_store(args[i], var_alloca); // 存储参数值
-                scope.push(param->id, var_alloca); // 加入作用域
-            }
-            else {
-                var_alloca = builder->create_alloca(FLOAT_T); // 为浮点数参数分配空间
-                builder->create_store(args[i], var_alloca); // 存储参数值
-                scope.push(param->id, var_alloca); // 加入作用域
-            }
-        }
+        auto var = create_variable(args[i]->get_type(), param->id); // 为参数创建变量
+        store_variable(args[i], var);       // 存储参数值
+        scope.push(param->id, var);         // 加入作用域
     }
 
     // 访问函数体复合语句
@@ -174,6 +153,7 @@ Value* CminusfBuilder::visit(ASTFunDeclaration &node) {
         else
             builder->create_ret(CONST_INT(0)); // 整数函数返回 0
     }
+    finish_function();                      // 清理 SSA 构造的状态
     scope.exit();                           // 退出函数作用域
     return nullptr;                         // 返回空指针，函数声明不产生直接返回值
 }
@@ -210,6 +190,8 @@ Value* CminusfBuilder::visit(ASTExpressionStmt &node) {
 // 访问 ASTSelectionStmt 节点：处理选择语句（if-else）
 Value* CminusfBuilder::visit(ASTSelectionStmt &node) {
     // if-else语句处理：生成条件分支
+    // 条件本身是比较表达式时直接使用其 i1 结果
+    context.is_cond = std::dynamic_pointer_cast<ASTSimpleExpression>(node.expression) != nullptr;
     node.expression->accept(*this);         // 访问条件表达式
     auto cur_val = context.val;             // 获取条件表达式的值
     auto trueBB = BasicBlock::create(module.get(), "", context.func); // 创建真分支基本块
@@ -218,7 +200,9 @@ Value* CminusfBuilder::visit(ASTSelectionStmt &node) {
 
     Value *cond_val;
     // 根据表达式类型生成比较指令
-    if (is_FLOAT(cur_val))
+    if (cur_val->get_type()->is_int1_type())
+        cond_val = cur_val;                 // 已经是 i1，无需再与 0 比较
+    else if (is_FLOAT(cur_val))
         cond_val = builder->create_fcmp_ne(cur_val, CONST_FP(0.)); // 浮点数非零比较
     else
         cond_val = builder->create_icmp_ne(cur_val, CONST_INT(0)); // 整数非零比较
@@ -228,6 +212,9 @@ Value* CminusfBuilder::visit(ASTSelectionStmt &node) {
         builder->create_cond_br(cond_val, trueBB, falseBB); // 有 else 分支
     else
         builder->create_cond_br(cond_val, trueBB, endBB); // 无 else 分支
+    seal_block(trueBB);                     // 分支块只有当前块一个前驱
+    if (node.else_statement != nullptr)
+        seal_block(falseBB);
 
     // 处理真分支
     builder->set_insert_point(trueBB);      // 设置插入点为真分支
@@ -245,6 +232,7 @@ Value* CminusfBuilder::visit(ASTSelectionStmt &node) {
     else
         falseBB->erase_from_parent();       // 删除未使用的假分支
 
+    seal_block(endBB);                      // 两个分支都已生成，结束块的前驱已确定
     builder->set_insert_point(endBB);        // 设置插入点为结束基本块
     return nullptr;                         // 返回空指针，选择语句不产生直接返回值
 }
@@ -261,23 +249,29 @@ Value* CminusfBuilder::visit(ASTIterationStmt &node) {
 
     // 处理条件判断
     builder->set_insert_point(judgeBB);     // 设置插入点为判断块
+    context.is_cond = std::dynamic_pointer_cast<ASTSimpleExpression>(node.expression) != nullptr;
     node.expression->accept(*this);         // 访问循环条件表达式
     
     auto cur_val = context.val;             // 获取条件表达式的值
     Value* cond_val;
     // 根据表达式类型生成比较指令
-    if (cur_val->get_type()->is_float_type())
+    if (cur_val->get_type()->is_int1_type())
+        cond_val = cur_val;                 // 已经是 i1，无需再与 0 比较
+    else if (cur_val->get_type()->is_float_type())
         cond_val = builder->create_fcmp_ne(cur_val, CONST_FP(0.)); // 浮点数非零比较
     else
         cond_val = builder->create_icmp_ne(cur_val, CONST_INT(0)); // 整数非零比较
 
     builder->create_cond_br(cond_val, stmtBB, endBB); // 创建条件分支：真跳转到循环体，假跳转到结束
+    seal_block(stmtBB);
+    seal_block(endBB);
 
     // 处理循环体
     builder->set_insert_point(stmtBB);      // 设置插入点为循环体
     node.statement->accept(*this);           // 访问循环体语句
     if (!builder->get_insert_block()->is_terminated())
         builder->create_br(judgeBB);         // 如果未终止，跳转回判断块
+    seal_block(judgeBB);                    // 回边已生成，判断块的前驱已确定
 
     builder->set_insert_point(endBB);        // 设置插入点为结束块
     return nullptr;                         // 返回空指针，迭代语句不产生直接返回值
@@ -323,7 +317,7 @@ Value* CminusfBuilder::visit(ASTVar &node) {
         else {
             // 右值：加载变量值或获取数组首地址
             if (is_POINTER_FLOAT(cur_var) || is_POINTER_INTEGER(cur_var) || is_POINTER_POINTER(cur_var))
-                context.val = builder->create_load(cur_var); // 加载指针指向的值
+                context.val = load_variable(cur_var); // 读取变量的值
             else
                 context.val = builder->create_gep(cur_var, {CONST_INT(0), CONST_INT(0)}); // 获取数组首地址
         }
@@ -336,29 +330,34 @@ Value* CminusfBuilder::visit(ASTVar &node) {
         if (cur_val->get_type()->is_float_type())
             cur_val = builder->create_fptosi(cur_val, INT32_T); // 如果索引为浮点数，转换为整数
         auto cur_fun = context.func;        // 获取当前函数
-        auto condBB = BasicBlock::create(module.get(), "", cur_fun); // 创建正常索引基本块
-        auto exceptBB = BasicBlock::create(module.get(), "", cur_fun); // 创建负索引异常基本块
         Value* is_neg = builder->create_icmp_lt(cur_val, CONST_INT(0)); // 检查索引是否为负
-        builder->create_cond_br(is_neg, exceptBB, condBB); // 负索引跳转到异常块
-
-        // 处理负索引异常
-        builder->set_insert_point(exceptBB); // 设置插入点为异常块
-        auto deal_fail = scope.find("neg_idx_except"); // 查找负索引异常处理函数
-        builder->create_call(static_cast<Function *>(deal_fail), {}); // 调用异常处理函数
-
-        // 根据函数返回类型生成默认返回
-        if (cur_fun->get_return_type()->is_void_type())
-            builder->create_void_ret();      // void 函数返回
-        else if (cur_fun->get_return_type()->is_float_type())
-            builder->create_ret(CONST_FP(0.)); // 浮点数函数返回 0.0
-        else
-            builder->create_ret(CONST_INT(0)); // 整数函数返回 0
+        auto never_neg = dynamic_cast<ConstantInt *>(is_neg); // 折叠后为常量 false 时无需检查
+        if (never_neg == nullptr || never_neg->get_value() != 0) {
+            auto condBB = BasicBlock::create(module.get(), "", cur_fun); // 创建正常索引基本块
+            auto exceptBB = BasicBlock::create(module.get(), "", cur_fun); // 创建负索引异常基本块
+            builder->create_cond_br(is_neg, exceptBB, condBB); // 负索引跳转到异常块
+            seal_block(exceptBB);
+            seal_block(condBB);
+
+            // 处理负索引异常
+            builder->set_insert_point(exceptBB); // 设置插入点为异常块
+            auto deal_fail = scope.find("neg_idx_except"); // 查找负索引异常处理函数
+            builder->create_call(static_cast<Function *>(deal_fail), {}); // 调用异常处理函数
+
+            // 根据函数返回类型生成默认返回
+            if (cur_fun->get_return_type()->is_void_type())
+                builder->create_void_ret();      // void 函数返回
+            else if (cur_fun->get_return_type()->is_float_type())
+                builder->create_ret(CONST_FP(0.)); // 浮点数函数返回 0.0
+            else
+                builder->create_ret(CONST_INT(0)); // 整数函数返回 0
 
-        // 处理正常索引
-        builder->set_insert_point(condBB);  // 设置插入点为正常索引块
+            // 处理正常索引
+            builder->set_insert_point(condBB);  // 设置插入点为正常索引块
+        }
         Value* new_ptr;
         if (is_POINTER_POINTER(cur_var)) {
-            auto array_ptr = builder->create_load(cur_var); // 加载指针数组的基地址
+            auto array_ptr = load_variable(cur_var); // 读取数组参数的基地址
             new_ptr = builder->create_gep(array_ptr, {cur_val}); // 计算元素地址
         }
         else if (is_POINTER_FLOAT(cur_var) || is_POINTER_INTEGER(cur_var)) {
@@ -394,7 +393,7 @@ Value* CminusfBuilder::visit(ASTAssignExpression &node) {
         else
             value = builder->create_fptosi(value, INT32_T); // 浮点数转换为整数
     }
-    builder->create_store(value, var_alloc); // 生成存储指令
+    store_variable(value, var_alloc);       // 生成存储指令或更新 SSA 定值
     context.val = value;                    // 更新上下文值
     return nullptr;                         // 返回空指针，赋值表达式不产生直接返回值
 }
@@ -402,6 +401,8 @@ Value* CminusfBuilder::visit(ASTAssignExpression &node) {
 // 访问 ASTSimpleExpression 节点：处理简单表达式（比较）
 Value* CminusfBuilder::visit(ASTSimpleExpression &node) {
     // 简单表达式处理：处理比较运算
+    bool as_cond = context.is_cond;         // 是否直接作为分支条件
+    context.is_cond = false;                // 子表达式按普通值求值
     if (node.additive_expression_r == nullptr)
         node.additive_expression_l->accept(*this); // 单一表达式：直接访问左侧表达式
     else {
@@ -464,7 +465,10 @@ Value* CminusfBuilder::visit(ASTSimpleExpression &node) {
             default:
                 break;                          // 默认情况：不处理
         }
-        context.val = builder->create_zext(flag, INT32_T); // 将比较结果扩展为 32 位整数
+        if (as_cond)
+            context.val = flag;                 // 作为条件时直接返回 i1
+        else
+            context.val = builder->create_zext(flag, INT32_T); // 将比较结果扩展为 32 位整数
     }
     return nullptr;                         // 返回空指针，简单表达式不产生直接返回值
 }
@@ -576,4 +580,138 @@ Value* CminusfBuilder::visit(ASTCall &node) {
     }
     context.val = builder->create_call(static_cast<Function *>(cur_fun), args); // 生成函数调用指令
     return nullptr;                         // 返回空指针，函数调用不产生直接返回值
-}
\ No newline at end of file
+}
+// 未赋值变量的取值，与全局变量一致按零初始化
+static Value *zero_value(Type *ty, Module *m) {
+    if (ty->is_integer_type())
+        return ConstantInt::get(0, m);
+    if (ty->is_float_type())
+        return ConstantFP::get(0., m);
+    return ConstantZero::get(ty, m);
+}
+
+// 创建标量变量：直接构造 SSA 时返回 SSAVariable，否则在栈上分配空间
+Value* CminusfBuilder::create_variable(Type *ty, const std::string &name) {
+    if (!direct_ssa_)
+        return builder->create_alloca(ty);
+    ssa_vars_.push_back(std::make_unique<SSAVariable>(module->get_pointer_type(ty), name));
+    return ssa_vars_.back().get();
+}
+
+// 读取变量的值
+Value* CminusfBuilder::load_variable(Value *var) {
+    if (auto ssa_var = dynamic_cast<SSAVariable *>(var))
+        return read_variable(ssa_var, builder->get_insert_block());
+    return builder->create_load(var);
+}
+
+// 写入变量的值
+void CminusfBuilder::store_variable(Value *val, Value *var) {
+    if (auto ssa_var = dynamic_cast<SSAVariable *>(var))
+        write_variable(ssa_var, builder->get_insert_block(), val);
+    else
+        builder->create_store(val, var);
+}
+
+void CminusfBuilder::write_variable(SSAVariable *var, BasicBlock *bb, Value *val) {
+    current_def_[var][bb] = val;
+}
+
+Value* CminusfBuilder::read_variable(SSAVariable *var, BasicBlock *bb) {
+    auto &defs = current_def_[var];
+    auto iter = defs.find(bb);
+    if (iter != defs.end())
+        return iter->second;                // 块内已有定值
+    return read_variable_recursive(var, bb);
+}
+
+Value* CminusfBuilder::read_variable_recursive(SSAVariable *var, BasicBlock *bb) {
+    auto ty = var->get_type()->get_pointer_element_type();
+    auto &pre_bbs = bb->get_pre_basic_blocks();
+    Value *val;
+    if (sealed_blocks_.find(bb) == sealed_blocks_.end()) {
+        // 前驱尚未确定：先放置不完整的 phi，封闭时再补全参数
+        auto phi = PhiInst::create_phi(ty, bb);
+        bb->add_instr_begin(phi);
+        incomplete_phis_[bb][var] = phi;
+        val = phi;
+    }
+    else if (pre_bbs.size() == 1) {
+        val = read_variable(var, pre_bbs.front()); // 唯一前驱无需 phi
+    }
+    else if (pre_bbs.empty()) {
+        val = zero_value(ty, module.get()); // 入口块或不可达块中读取未赋值的变量
+    }
+    else {
+        // 先写入 phi 以打断经由环路的递归读取
+        auto phi = PhiInst::create_phi(ty, bb);
+        bb->add_instr_begin(phi);
+        write_variable(var, bb, phi);
+        val = add_phi_operands(var, phi);
+    }
+    write_variable(var, bb, val);
+    return val;
+}
+
+Value* CminusfBuilder::add_phi_operands(SSAVariable *var, PhiInst *phi) {
+    auto bb = phi->get_parent();
+    for (auto pre_bb : bb->get_pre_basic_blocks())
+        phi->add_phi_pair_operand(read_variable(var, pre_bb), pre_bb);
+    return try_remove_trivial_phi(phi);
+}
+
+// 所有参数都相同（或为 phi 自身）的 phi 是平凡的，用该参数替换
+Value* CminusfBuilder::try_remove_trivial_phi(PhiInst *phi) {
+    Value *same = nullptr;
+    for (auto [val, pre_bb] : phi->get_phi_pairs()) {
+        if (val == same || val == phi)
+            continue;
+        if (same != nullptr)
+            return phi;                     // 至少有两个不同的参数
+        same = val;
+    }
+    if (same == nullptr)
+        same = zero_value(phi->get_type(), module.get()); // 只引用自身，变量从未赋值
+
+    std::set<PhiInst *> phi_users;
+    for (auto &use : phi->get_use_list()) {
+        auto user = dynamic_cast<PhiInst *>(use.val_);
+        if (user != nullptr && user != phi)
+            phi_users.insert(user);
+    }
+    phi->replace_all_use_with(same);
+    phi->remove_all_operands();
+    phi->get_parent()->remove_instr(phi);
+    removed_phis_.insert(phi);
+    for (auto &[var, defs] : current_def_)
+        for (auto &[bb, val] : defs)
+            if (val == phi)
+                val = same;
+
+    // 替换后使用者也可能变为平凡 phi
+    for (auto user : phi_users)
+        if (removed_phis_.find(user) == removed_phis_.end())
+            try_remove_trivial_phi(user);
+    return same;
+}
+
+void CminusfBuilder::seal_block(BasicBlock *bb) {
+    auto iter = incomplete_phis_.find(bb);
+    if (iter != incomplete_phis_.end()) {
+        auto phis = std::move(iter->second);
+        incomplete_phis_.erase(iter);
+        for (auto &[var, phi] : phis)
+            if (removed_phis_.find(phi) == removed_phis_.end())
+                add_phi_operands(var, phi);
+    }
+    sealed_blocks_.insert(bb);
+}
+
+void CminusfBuilder::finish_function() {
+    assert(incomplete_phis_.empty() && "unsealed basic block");
+    current_def_.clear();
+    sealed_blocks_.clear();
+    for (auto phi : removed_phis_)
+        delete phi;
+    removed_phis_.clear();
+}
@@ -1,9 +1,23 @@
+#include "ArgPromotion.hpp"
+#include "AutoMemoize.hpp"
+#include "CheckElimination.hpp"
 #include "ConstPropagation.hpp"
+#include "DeadArgElim.hpp"
 #include "DeadCode.hpp"
 #include "FunctionInline.hpp"
+#include "GlobalOpt.hpp"
+#include "IPSCCP.hpp"
+#include "IndVarSimplify.hpp"
+#include "InstCombine.hpp"
+#include "LoadStoreElim.hpp"
+#include "LoopPromotion.hpp"
+#include "LoopVersioning.hpp"
 #include "Mem2Reg.hpp"
 #include "Module.hpp"
+#include "PartialInline.hpp"
 #include "PassManager.hpp"
+#include "SROA.hpp"
+#include "TailRecursionElim.hpp"
 #include "ast.hpp"
 #include "cminusf_builder.hpp"
 
@@ -22,10 +36,29 @@ struct Config {
 
     bool emitast{false};
     bool emitllvm{false};
+    // 在 IR 生成时直接构造 SSA，关闭后标量变量经 alloca 生成并由 Mem2Reg 提升
+    bool builder_ssa{true};
+    // 在 IR 生成时折叠常量表达式
+    bool builder_fold{true};
     // optization config
     bool const_prop{false};
     bool dce{true};
     bool func_inline{false};
+    bool iv_simplify{false};
+    bool check_elim{false};
+    bool loop_version{false};
+    bool inst_combine{false};
+    bool global_opt{false};
+    bool loop_promote{false};
+    bool sroa{false};
+    bool load_store_elim{false};
+    bool partial_inline{false};
+    bool tail_rec_elim{false};
+    bool ipsccp{false};
+    bool dead_arg_elim{false};
+    bool arg_promotion{false};
+    bool auto_memoize{false};
+    bool adce{false};
 
     Config(int argc, char **argv) : argc(argc), argv(argv) {
         parse_cmd_line();
@@ -54,7 +87,7 @@ int main(int argc, char **argv) {
         ast.run_visitor(printer);
     } else {
         std::unique_ptr<Module> m;
-        CminusfBuilder builder;
+        CminusfBuilder builder(config.builder_ssa, config.builder_fold);
         ast.run_visitor(builder);
         m = builder.getModule();
 
@@ -64,17 +97,104 @@ int main(int argc, char **argv) {
             PM.add_pass<DeadCode>();
         }
 
+        // 消除尾递归后函数不再递归，可以被内联
+        if (config.tail_rec_elim) {
+            PM.add_pass<TailRecursionElim>();
+            PM.add_pass<DeadCode>();
+        }
+
         if (config.func_inline) {
             PM.add_pass<FunctionInline>();
             PM.add_pass<DeadCode>();
         }
 
-        if (config.const_prop) {
+        if (config.partial_inline) {
+            PM.add_pass<PartialInline>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if (config.global_opt) {
+            PM.add_pass<GlobalOpt>();
+        }
+
+        if (config.sroa) {
+            PM.add_pass<SROA>();
+        }
+
+        // 以下优化均要求 SSA 形式，GlobalOpt 局部化的全局变量与 SROA
+        // 拆分出的标量也需要提升
+        if (config.global_opt || config.sroa ||
+            (not config.builder_ssa &&
+             (config.const_prop || config.iv_simplify || config.check_elim ||
+              config.loop_version || config.inst_combine ||
+              config.loop_promote || config.load_store_elim ||
+              config.ipsccp || config.dead_arg_elim ||
+              config.arg_promotion || config.auto_memoize))) {
             PM.add_pass<Mem2Reg>();
             PM.add_pass<DeadCode>();
+        }
+
+        if (config.ipsccp) {
+            PM.add_pass<IPSCCP>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if (config.arg_promotion) {
+            PM.add_pass<ArgPromotion>();
+            PM.add_pass<DeadCode>();
+        }
+
+        // 在 IPSCCP 之后运行，被替换为常量的形参也成为无用参数
+        if (config.dead_arg_elim) {
+            PM.add_pass<DeadArgElim>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if (config.loop_promote) {
+            PM.add_pass<LoopPromotion>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if (config.inst_combine) {
+            PM.add_pass<InstCombine>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if (config.const_prop) {
             PM.add_pass<ConstPropagation>();
             PM.add_pass<DeadCode>();
         }
+
+        if (config.load_store_elim) {
+            PM.add_pass<LoadStoreElim>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if (config.check_elim) {
+            PM.add_pass<CheckElimination>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if (config.loop_version) {
+            PM.add_pass<LoopVersioning>();
+            PM.add_pass<DeadCode>();
+        }
+
+        if (config.iv_simplify) {
+            PM.add_pass<IndVarSimplify>();
+            PM.add_pass<DeadCode>();
+        }
+
+        // 前面的优化折叠掉分支条件后，整段条件结构可能都已无用
+        if (config.adce) {
+            PM.add_pass<DeadCode>(true);
+        }
+
+        // 插入的运行时调用使函数不再是纯函数，放在最后运行
+        if (config.auto_memoize) {
+            PM.add_pass<AutoMemoize>();
+            PM.add_pass<DeadCode>();
+        }
         PM.run();
 
         std::ofstream output_stream(config.output_file);
@@ -105,12 +225,46 @@ void Config::parse_cmd_line() {
             emitast = true;
         } else if (argv[i] == "-emit-llvm"s) {
             emitllvm = true;
+        } else if (argv[i] == "-no-builder-ssa"s) {
+            builder_ssa = false;
+        } else if (argv[i] == "-no-builder-fold"s) {
+            builder_fold = false;
         } else if (argv[i] == "-dce"s) {
             dce = true;
         } else if (argv[i] == "-const-prop"s) {
             const_prop = true;
         } else if (argv[i] == "-func-inline"s) {
             func_inline = true;
+        } else if (argv[i] == "-iv-simplify"s) {
+            iv_simplify = true;
+        } else if (argv[i] == "-check-elim"s) {
+            check_elim = true;
+        } else if (argv[i] == "-loop-version"s) {
+            loop_version = true;
+        } else if (argv[i] == "-inst-combine"s) {
+            inst_combine = true;
+        } else if (argv[i] == "-global-opt"s) {
+            global_opt = true;
+        } else if (argv[i] == "-loop-promote"s) {
+            loop_promote = true;
+        } else if (argv[i] == "-sroa"s) {
+            sroa = true;
+        } else if (argv[i] == "-load-store-elim"s) {
+            load_store_elim = true;
+        } else if (argv[i] == "-partial-inline"s) {
+            partial_inline = true;
+        } else if (argv[i] == "-tail-rec-elim"s) {
+            tail_rec_elim = true;
+        } else if (argv[i] == "-ipsccp"s) {
+            ipsccp = true;
+        } else if (argv[i] == "-dead-arg-elim"s) {
+            dead_arg_elim = true;
+        } else if (argv[i] == "-arg-promotion"s) {
+            arg_promotion = true;
+        } else if (argv[i] == "-auto-memoize"s) {
+            auto_memoize = true;
+        } else if (argv[i] == "-adce"s) {
+            adce = true;
         } else {
             if (input_file.empty()) {
                 input_file = argv[i];
@@ -136,6 +290,51 @@ void Config::check() {
     if (func_inline && not dce) {
         print_err("function inline pass need dce pass");
     }
+    if (iv_simplify && not dce) {
+        print_err("iv-simplify pass need dce pass");
+    }
+    if (check_elim && not dce) {
+        print_err("check-elim pass need dce pass");
+    }
+    if (loop_version && not dce) {
+        print_err("loop-version pass need dce pass");
+    }
+    if (inst_combine && not dce) {
+        print_err("inst-combine pass need dce pass");
+    }
+    if (global_opt && not dce) {
+        print_err("global-opt pass need dce pass");
+    }
+    if (loop_promote && not dce) {
+        print_err("loop-promote pass need dce pass");
+    }
+    if (sroa && not dce) {
+        print_err("sroa pass need dce pass");
+    }
+    if (load_store_elim && not dce) {
+        print_err("load-store-elim pass need dce pass");
+    }
+    if (partial_inline && not dce) {
+        print_err("partial-inline pass need dce pass");
+    }
+    if (tail_rec_elim && not dce) {
+        print_err("tail-rec-elim pass need dce pass");
+    }
+    if (ipsccp && not dce) {
+        print_err("ipsccp pass need dce pass");
+    }
+    if (dead_arg_elim && not dce) {
+        print_err("dead-arg-elim pass need dce pass");
+    }
+    if (arg_promotion && not dce) {
+        print_err("arg-promotion pass need dce pass");
+    }
+    if (auto_memoize && not dce) {
+        print_err("auto-memoize pass need dce pass");
+    }
+    if (adce && not dce) {
+        print_err("adce pass need dce pass");
+    }
     if (output_file.empty()) {
         output_file = input_file.stem();
         if (emitllvm) {
@@ -148,7 +347,12 @@ void Config::print_help() const {
     std::cout
         << "Usage: " << exe_name
         << " [-h|--help] [-o <target-file>] [-emit-llvm] [-S] [-dump-json]"
-           "[-const-prop] [-dce]"
+           "[-no-builder-ssa] [-no-builder-fold] "
+           "[-const-prop] [-dce] [-func-inline] [-iv-simplify] [-check-elim]"
+           " [-loop-version] [-inst-combine] [-global-opt]"
+           " [-loop-promote] [-sroa] [-load-store-elim] [-partial-inline]"
+           " [-tail-rec-elim] [-ipsccp] [-dead-arg-elim] [-arg-promotion]"
+           " [-auto-memoize] [-adce]"
            "<input-file>"
         << std::endl;
     exit(0);
@@ -35,6 +35,31 @@ Instruction *BasicBlock::get_terminator() {
     return &instr_list_.back();
 }
 
+void BasicBlock::replace_phi_pred(BasicBlock *old_pred, BasicBlock *new_pred) {
+    for (auto &instr : instr_list_) {
+        if (not instr.is_phi()) {
+            break;
+        }
+        for (unsigned i = 1; i < instr.get_num_operand(); i += 2) {
+            if (instr.get_operand(i) == old_pred) {
+                instr.set_operand(i, new_pred);
+            }
+        }
+    }
+}
+
+void BasicBlock::redirect_succ_phis(BasicBlock *old_pred) {
+    if (not is_terminated()) {
+        return;
+    }
+    // Walk the terminator instead of succ_bbs_, which may not be updated yet
+    for (auto op : get_terminator()->get_operands()) {
+        if (auto succ = dynamic_cast<BasicBlock *>(op)) {
+            succ->replace_phi_pred(old_pred, this);
+        }
+    }
+}
+
 void BasicBlock::add_instruction(Instruction *instr) {
     // assert(not is_terminated() && "Inserting instruction to terminated bb");
     instr_list_.push_back(instr);
@@ -0,0 +1,236 @@
+#include "ConstFolder.hpp"
+
+#include <cassert>
+#include <climits>
+#include <cmath>
+
+// 计算整数二元运算与比较，按 32 位补码回绕
+Constant *ConstFolder::compute_int(Instruction::OpID op, int value1,
+                                   int value2) {
+    auto u_value1 = static_cast<unsigned>(value1);
+    auto u_value2 = static_cast<unsigned>(value2);
+    switch (op) {
+    case Instruction::add:
+        return ConstantInt::get(static_cast<int>(u_value1 + u_value2), module_);
+    case Instruction::sub:
+        return ConstantInt::get(static_cast<int>(u_value1 - u_value2), module_);
+    case Instruction::mul:
+        return ConstantInt::get(static_cast<int>(u_value1 * u_value2), module_);
+    case Instruction::sdiv:
+        if (value2 == 0 or (value1 == INT_MIN and value2 == -1))
+            return nullptr;
+        return ConstantInt::get(value1 / value2, module_);
+    case Instruction::eq:
+        return ConstantInt::get(value1 == value2, module_);
+    case Instruction::ne:
+        return ConstantInt::get(value1 != value2, module_);
+    case Instruction::gt:
+        return ConstantInt::get(value1 > value2, module_);
+    case Instruction::ge:
+        return ConstantInt::get(value1 >= value2, module_);
+    case Instruction::lt:
+        return ConstantInt::get(value1 < value2, module_);
+    case Instruction::le:
+        return ConstantInt::get(value1 <= value2, module_);
+    default:
+        return nullptr;
+    }
+}
+
+// 计算浮点二元运算与比较，LightIR 的浮点比较是无序比较，任一操作数为 NaN 时为真
+Constant *ConstFolder::compute_fp(Instruction::OpID op, float value1,
+                                  float value2) {
+    bool unordered = std::isnan(value1) or std::isnan(value2);
+    switch (op) {
+    case Instruction::fadd:
+        return ConstantFP::get(value1 + value2, module_);
+    case Instruction::fsub:
+        return ConstantFP::get(value1 - value2, module_);
+    case Instruction::fmul:
+        return ConstantFP::get(value1 * value2, module_);
+    case Instruction::fdiv:
+        return value2 != 0.0f ? ConstantFP::get(value1 / value2, module_)
+                              : nullptr;
+    case Instruction::feq:
+        return ConstantInt::get(unordered or value1 == value2, module_);
+    case Instruction::fne:
+        return ConstantInt::get(unordered or value1 != value2, module_);
+    case Instruction::fgt:
+        return ConstantInt::get(unordered or value1 > value2, module_);
+    case Instruction::fge:
+        return ConstantInt::get(unordered or value1 >= value2, module_);
+    case Instruction::flt:
+        return ConstantInt::get(unordered or value1 < value2, module_);
+    case Instruction::fle:
+        return ConstantInt::get(unordered or value1 <= value2, module_);
+    default:
+        return nullptr;
+    }
+}
+
+Constant *ConstFolder::compute(Instruction::OpID op, Constant *value1,
+                               Constant *value2) {
+    auto int1 = dynamic_cast<ConstantInt *>(value1);
+    auto int2 = dynamic_cast<ConstantInt *>(value2);
+    if (int1 and int2)
+        return compute_int(op, int1->get_value(), int2->get_value());
+    auto fp1 = dynamic_cast<ConstantFP *>(value1);
+    auto fp2 = dynamic_cast<ConstantFP *>(value2);
+    if (fp1 and fp2)
+        return compute_fp(op, fp1->get_value(), fp2->get_value());
+    return nullptr;
+}
+
+// 计算类型转换
+Constant *ConstFolder::compute(Instruction::OpID op, Constant *value1) {
+    auto int1 = dynamic_cast<ConstantInt *>(value1);
+    auto fp1 = dynamic_cast<ConstantFP *>(value1);
+    switch (op) {
+    case Instruction::sitofp:
+        if (int1)
+            return ConstantFP::get(static_cast<float>(int1->get_value()),
+                                   module_);
+        return nullptr;
+    case Instruction::fptosi:
+        // 超出 i32 范围（含 NaN）时结果未定义
+        if (fp1 and fp1->get_value() > -2147483904.0f and
+            fp1->get_value() < 2147483648.0f)
+            return ConstantInt::get(static_cast<int>(fp1->get_value()),
+                                    module_);
+        return nullptr;
+    case Instruction::zext:
+        if (int1)
+            return ConstantInt::get(int1->get_value(), module_);
+        return nullptr;
+    default:
+        return nullptr;
+    }
+}
+
+Value *ConstFolder::simplify(Instruction::OpID op, Value *lhs, Value *rhs) {
+    auto c_lhs = dynamic_cast<Constant *>(lhs);
+    auto c_rhs = dynamic_cast<Constant *>(rhs);
+    if (c_lhs and c_rhs)
+        return compute(op, c_lhs, c_rhs);
+
+    auto is_int = [](Value *val, int expected) {
+        auto c = dynamic_cast<ConstantInt *>(val);
+        return c != nullptr and c->get_value() == expected;
+    };
+    // 浮点只使用对 -0.0 与 NaN 也成立的恒等式，因此常量必须是 +0.0 或 1.0
+    auto is_fp = [](Value *val, float expected) {
+        auto c = dynamic_cast<ConstantFP *>(val);
+        return c != nullptr and c->get_value() == expected and
+               not std::signbit(c->get_value());
+    };
+    switch (op) {
+    case Instruction::add:
+        if (is_int(rhs, 0))
+            return lhs;
+        if (is_int(lhs, 0))
+            return rhs;
+        break;
+    case Instruction::sub:
+        if (is_int(rhs, 0))
+            return lhs;
+        if (lhs == rhs)
+            return ConstantInt::get(0, module_);
+        break;
+    case Instruction::mul:
+        if (is_int(rhs, 1))
+            return lhs;
+        if (is_int(lhs, 1))
+            return rhs;
+        if (is_int(lhs, 0) or is_int(rhs, 0))
+            return ConstantInt::get(0, module_);
+        break;
+    case Instruction::sdiv:
+        if (is_int(rhs, 1))
+            return lhs;
+        break;
+    case Instruction::fsub:
+        if (is_fp(rhs, 0.0f))
+            return lhs;
+        break;
+    case Instruction::fmul:
+        if (is_fp(rhs, 1.0f))
+            return lhs;
+        if (is_fp(lhs, 1.0f))
+            return rhs;
+        break;
+    case Instruction::fdiv:
+        if (is_fp(rhs, 1.0f))
+            return lhs;
+        break;
+    case Instruction::eq:
+    case Instruction::ge:
+    case Instruction::le:
+        if (lhs == rhs)
+            return ConstantInt::get(true, module_);
+        break;
+    case Instruction::ne:
+    case Instruction::gt:
+    case Instruction::lt:
+        if (lhs == rhs)
+            return ConstantInt::get(false, module_);
+        break;
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+Value *ConstFolder::simplify(Instruction::OpID op, Value *val) {
+    if (auto c = dynamic_cast<Constant *>(val))
+        return compute(op, c);
+    return nullptr;
+}
+
+Instruction::OpID ConstFolder::invert_predicate(Instruction::OpID op) {
+    switch (op) {
+    case Instruction::lt:
+        return Instruction::ge;
+    case Instruction::le:
+        return Instruction::gt;
+    case Instruction::gt:
+        return Instruction::le;
+    case Instruction::ge:
+        return Instruction::lt;
+    case Instruction::eq:
+        return Instruction::ne;
+    case Instruction::ne:
+        return Instruction::eq;
+    default:
+        assert(false && "invert_predicate only supports icmp");
+        return op;
+    }
+}
+
+Instruction::OpID ConstFolder::swap_predicate(Instruction::OpID op) {
+    switch (op) {
+    case Instruction::lt:
+        return Instruction::gt;
+    case Instruction::le:
+        return Instruction::ge;
+    case Instruction::gt:
+        return Instruction::lt;
+    case Instruction::ge:
+        return Instruction::le;
+    case Instruction::flt:
+        return Instruction::fgt;
+    case Instruction::fle:
+        return Instruction::fge;
+    case Instruction::fgt:
+        return Instruction::flt;
+    case Instruction::fge:
+        return Instruction::fle;
+    case Instruction::eq:
+    case Instruction::ne:
+    case Instruction::feq:
+    case Instruction::fne:
+        return op;
+    default:
+        assert(false && "swap_predicate only supports comparisons");
+        return op;
+    }
+}
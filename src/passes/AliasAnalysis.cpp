@@ -0,0 +1,260 @@
+#include "AliasAnalysis.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+
+static bool is_identified_object(Value *val) {
+    return dynamic_cast<AllocaInst *>(val) != nullptr or
+           dynamic_cast<GlobalVariable *>(val) != nullptr;
+}
+
+// 在循环的不同迭代中可能取不同的值：除 alloca 外的指令都保守地视为可能
+static bool may_vary(Value *val) {
+    return dynamic_cast<Instruction *>(val) != nullptr and
+           dynamic_cast<AllocaInst *>(val) == nullptr;
+}
+
+void AliasAnalysis::run() {
+    func_info_ = std::make_unique<FuncInfo>(m_);
+    func_info_->run();
+    may_point_global_.clear();
+    escaped_.clear();
+    alias_cache_.clear();
+    collect_escaped();
+    compute_arg_targets();
+}
+
+Value *AliasAnalysis::get_underlying_object(Value *ptr) {
+    while (auto gep = dynamic_cast<GetElementPtrInst *>(ptr))
+        ptr = gep->get_operand(0);
+    return ptr;
+}
+
+// 把下标拆成 var + c，处理与常量的加减
+std::pair<Value *, int> AliasAnalysis::decompose_index(Value *idx) {
+    int offset = 0;
+    while (true) {
+        if (auto c = dynamic_cast<ConstantInt *>(idx))
+            return {nullptr, offset + c->get_value()};
+        auto inst = dynamic_cast<Instruction *>(idx);
+        if (inst == nullptr or (not inst->is_add() and not inst->is_sub()))
+            return {idx, offset};
+        auto rhs = dynamic_cast<ConstantInt *>(inst->get_operand(1));
+        auto lhs = dynamic_cast<ConstantInt *>(inst->get_operand(0));
+        if (rhs != nullptr) {
+            offset += inst->is_add() ? rhs->get_value() : -rhs->get_value();
+            idx = inst->get_operand(0);
+        } else if (lhs != nullptr and inst->is_add()) {
+            offset += lhs->get_value();
+            idx = inst->get_operand(1);
+        } else {
+            return {idx, offset};
+        }
+    }
+}
+
+AliasAnalysis::Location AliasAnalysis::get_location(Value *ptr) {
+    Location loc{ptr, nullptr, 0, true};
+    while (auto gep = dynamic_cast<GetElementPtrInst *>(loc.base)) {
+        // gep [N x T]* p, 0, idx 与 gep T* p, idx 都是在 p 上偏移 idx 个元素
+        Value *idx = nullptr;
+        if (gep->get_num_operand() == 3) {
+            auto first = dynamic_cast<ConstantInt *>(gep->get_operand(1));
+            if (first == nullptr or first->get_value() != 0)
+                loc.known = false;
+            idx = gep->get_operand(2);
+        } else if (gep->get_num_operand() == 2) {
+            idx = gep->get_operand(1);
+        } else {
+            loc.known = false;
+        }
+        if (idx != nullptr and loc.known) {
+            auto [var, offset] = decompose_index(idx);
+            if (var != nullptr and loc.var != nullptr)
+                loc.known = false;
+            else if (var != nullptr)
+                loc.var = var;
+            loc.offset += offset;
+        }
+        loc.base = gep->get_operand(0);
+    }
+    return loc;
+}
+
+AliasResult AliasAnalysis::alias_object(Value *base1, Value *base2) {
+    if (base1 == base2)
+        return AliasResult::MayAlias;
+    if (is_identified_object(base1) and is_identified_object(base2))
+        return AliasResult::NoAlias;
+    // 参数指针来自调用者，不会指向本函数的 alloca；
+    // 所有调用点都传入局部数组时也不会指向全局变量
+    auto arg_excludes = [this](Value *val, Value *object) {
+        auto arg = dynamic_cast<Argument *>(val);
+        if (arg == nullptr)
+            return false;
+        if (dynamic_cast<AllocaInst *>(object) != nullptr)
+            return true;
+        return dynamic_cast<GlobalVariable *>(object) != nullptr and
+               not may_point_global_.count(arg);
+    };
+    if (arg_excludes(base1, base2) or arg_excludes(base2, base1))
+        return AliasResult::NoAlias;
+    return AliasResult::MayAlias;
+}
+
+AliasResult AliasAnalysis::compute_alias(Value *ptr1, Value *ptr2,
+                                         bool across_iterations) {
+    if (ptr1 == ptr2 and not across_iterations)
+        return AliasResult::MustAlias;
+    auto loc1 = get_location(ptr1);
+    auto loc2 = get_location(ptr2);
+    if (loc1.base != loc2.base)
+        return alias_object(loc1.base, loc2.base);
+    if (across_iterations and
+        (may_vary(loc1.base) or may_vary(loc1.var) or may_vary(loc2.var)))
+        return AliasResult::MayAlias;
+    if (not loc1.known or not loc2.known or loc1.var != loc2.var)
+        return AliasResult::MayAlias;
+    return loc1.offset == loc2.offset ? AliasResult::MustAlias
+                                      : AliasResult::NoAlias;
+}
+
+AliasResult AliasAnalysis::alias(Value *ptr1, Value *ptr2,
+                                 bool across_iterations) {
+    auto inst = dynamic_cast<Instruction *>(ptr1);
+    if (inst == nullptr)
+        inst = dynamic_cast<Instruction *>(ptr2);
+    // 跨迭代的查询只来自 MemorySSA 沿回边的遍历，不缓存
+    if (inst == nullptr or across_iterations)
+        return compute_alias(ptr1, ptr2, across_iterations);
+    if (ptr2 < ptr1)
+        std::swap(ptr1, ptr2);
+    auto &cache = alias_cache_[inst->get_function()];
+    auto iter = cache.find({ptr1, ptr2});
+    if (iter != cache.end())
+        return iter->second;
+    auto result = compute_alias(ptr1, ptr2, false);
+    cache.emplace(std::make_pair(ptr1, ptr2), result);
+    return result;
+}
+
+ModRefInfo AliasAnalysis::get_mod_ref_info(CallInst *call) {
+    auto callee = static_cast<Function *>(call->get_operand(0));
+    if (callee->is_declaration())
+        return ModRefInfo::NoModRef;
+    auto &summary = func_info_->get_summary(callee);
+    auto info = ModRefInfo::NoModRef;
+    if (not summary.ref_globals.empty())
+        info = union_mod_ref(info, ModRefInfo::Ref);
+    if (not summary.mod_globals.empty())
+        info = union_mod_ref(info, ModRefInfo::Mod);
+    for (auto arg_info : summary.arg_mod_ref)
+        info = union_mod_ref(info, arg_info);
+    return info;
+}
+
+ModRefInfo AliasAnalysis::get_mod_ref_info(CallInst *call, Value *ptr) {
+    auto callee = static_cast<Function *>(call->get_operand(0));
+    if (callee->is_declaration())
+        return ModRefInfo::NoModRef;
+    auto &summary = func_info_->get_summary(callee);
+    auto object = get_underlying_object(ptr);
+    auto global = dynamic_cast<GlobalVariable *>(object);
+    auto arg = dynamic_cast<Argument *>(object);
+    auto info = ModRefInfo::NoModRef;
+    // 被调函数直接读写的全局变量
+    if (global != nullptr or
+        (arg != nullptr and may_point_global_.count(arg)) or
+        (arg == nullptr and not is_identified_object(object))) {
+        auto accessed = [&](const std::set<GlobalVariable *> &globals) {
+            return global == nullptr ? not globals.empty()
+                                     : globals.count(global) > 0;
+        };
+        if (accessed(summary.ref_globals))
+            info = union_mod_ref(info, ModRefInfo::Ref);
+        if (accessed(summary.mod_globals))
+            info = union_mod_ref(info, ModRefInfo::Mod);
+    }
+    // 经由实参被读写的内存
+    for (unsigned i = 0; i < summary.arg_mod_ref.size(); i++) {
+        if (summary.arg_mod_ref[i] == ModRefInfo::NoModRef)
+            continue;
+        auto op = call->get_operand(i + 1);
+        if (alias_object(get_underlying_object(op), object) !=
+            AliasResult::NoAlias)
+            info = union_mod_ref(info, summary.arg_mod_ref[i]);
+    }
+    return info;
+}
+
+ModRefInfo AliasAnalysis::get_mod_ref_info(Instruction *inst, Value *ptr) {
+    if (inst->is_load()) {
+        auto load = static_cast<LoadInst *>(inst);
+        return alias(load->get_lval(), ptr) == AliasResult::NoAlias
+                   ? ModRefInfo::NoModRef
+                   : ModRefInfo::Ref;
+    }
+    if (inst->is_store()) {
+        auto store = static_cast<StoreInst *>(inst);
+        return alias(store->get_lval(), ptr) == AliasResult::NoAlias
+                   ? ModRefInfo::NoModRef
+                   : ModRefInfo::Mod;
+    }
+    if (inst->is_call())
+        return get_mod_ref_info(static_cast<CallInst *>(inst), ptr);
+    return ModRefInfo::NoModRef;
+}
+
+void AliasAnalysis::collect_escaped() {
+    for (auto &f : m_->get_functions()) {
+        for (auto &bb : f.get_basic_blocks()) {
+            for (auto &inst : bb.get_instructions()) {
+                if (not inst.is_call())
+                    continue;
+                for (unsigned i = 1; i < inst.get_num_operand(); i++) {
+                    auto op = inst.get_operand(i);
+                    if (op->get_type()->is_pointer_type())
+                        escaped_.insert(get_underlying_object(op));
+                }
+            }
+        }
+    }
+}
+
+// 参数可能指向全局变量，当且仅当某个调用点传入的实参可能指向全局变量
+void AliasAnalysis::compute_arg_targets() {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto &f : m_->get_functions()) {
+            for (auto &bb : f.get_basic_blocks()) {
+                for (auto &inst : bb.get_instructions()) {
+                    if (not inst.is_call())
+                        continue;
+                    auto callee = static_cast<Function *>(inst.get_operand(0));
+                    if (callee->is_declaration())
+                        continue;
+                    auto arg_iter = callee->get_args().begin();
+                    for (unsigned i = 1; i < inst.get_num_operand();
+                         i++, ++arg_iter) {
+                        auto formal = &*arg_iter;
+                        if (not formal->get_type()->is_pointer_type() or
+                            may_point_global_.count(formal))
+                            continue;
+                        auto object =
+                            get_underlying_object(inst.get_operand(i));
+                        auto actual_arg = dynamic_cast<Argument *>(object);
+                        bool local =
+                            dynamic_cast<AllocaInst *>(object) != nullptr or
+                            (actual_arg != nullptr and
+                             not may_point_global_.count(actual_arg));
+                        if (not local) {
+                            may_point_global_.insert(formal);
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
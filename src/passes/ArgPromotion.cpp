@@ -0,0 +1,193 @@
+#include "ArgPromotion.hpp"
+#include "BasicBlock.hpp"
+#include "CloneFunction.hpp"
+#include "Constant.hpp"
+#include "logging.hpp"
+
+#include <algorithm>
+
+void ArgPromotion::run() {
+    alias_analysis_ = std::make_unique<AliasAnalysis>(m_);
+    alias_analysis_->run();
+    dominators_ = std::make_unique<Dominators>(m_);
+
+    // 先完成所有分析再改写，改写会删除原函数
+    std::vector<std::pair<Function *, std::map<unsigned, PromotedArg>>>
+        work_list;
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration() or f.get_name() == "main")
+            continue;
+        dominators_->run_on_func(&f);
+        std::map<unsigned, PromotedArg> promoted;
+        for (auto &arg : f.get_args()) {
+            if (not arg.get_type()->is_pointer_type())
+                continue;
+            PromotedArg info;
+            if (collect_loads(&arg, info) and is_read_only(&arg, info))
+                promoted.emplace(arg.get_arg_no(), std::move(info));
+        }
+        if (not promoted.empty())
+            work_list.push_back({&f, std::move(promoted)});
+    }
+    unsigned count = 0;
+    for (auto &[func, promoted] : work_list) {
+        count += promoted.size();
+        promote(func, promoted);
+    }
+    LOG_INFO << "argument promotion promoted " << count << " arguments";
+}
+
+bool ArgPromotion::collect_loads(Argument *arg, PromotedArg &promoted) {
+    for (auto &use : arg->get_use_list()) {
+        auto inst = dynamic_cast<Instruction *>(use.val_);
+        if (inst == nullptr or use.arg_no_ != 0)
+            return false;
+        if (inst->is_load()) {
+            promoted.loads[0].push_back(static_cast<LoadInst *>(inst));
+            continue;
+        }
+        if (not inst->is_gep() or inst->get_num_operand() != 2)
+            return false;
+        auto idx = dynamic_cast<ConstantInt *>(inst->get_operand(1));
+        if (idx == nullptr or idx->get_value() < 0)
+            return false;
+        for (auto &gep_use : inst->get_use_list()) {
+            auto load = dynamic_cast<LoadInst *>(gep_use.val_);
+            if (load == nullptr)
+                return false;
+            promoted.loads[idx->get_value()].push_back(load);
+        }
+        promoted.geps.push_back(inst);
+    }
+    if (promoted.loads.empty() or promoted.loads.size() > max_promoted_elems)
+        return false;
+
+    // 每个元素至少有一个 load 支配所有返回块
+    std::vector<BasicBlock *> ret_bbs;
+    for (auto &bb : arg->get_parent()->get_basic_blocks()) {
+        if (dominators_->get_dom_tree_level(&bb) >= 0 and
+            bb.get_terminator()->is_ret())
+            ret_bbs.push_back(&bb);
+    }
+    for (auto &[idx, loads] : promoted.loads) {
+        bool executed = false;
+        for (auto load : loads) {
+            auto bb = load->get_parent();
+            if (dominators_->get_dom_tree_level(bb) < 0)
+                continue;
+            executed = std::all_of(ret_bbs.begin(), ret_bbs.end(),
+                                   [&](BasicBlock *ret_bb) {
+                                       return dominators_->is_dominate(
+                                           bb, ret_bb);
+                                   });
+            if (executed)
+                break;
+        }
+        if (not executed or ret_bbs.empty())
+            return false;
+    }
+    return true;
+}
+
+bool ArgPromotion::is_read_only(Argument *arg, const PromotedArg &promoted) {
+    for (auto &bb : arg->get_parent()->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            if (not inst.is_store() and not inst.is_call())
+                continue;
+            for (auto &[idx, loads] : promoted.loads) {
+                auto ptr = loads.front()->get_lval();
+                if (is_mod(alias_analysis_->get_mod_ref_info(&inst, ptr)))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+void ArgPromotion::promote(Function *func,
+                           std::map<unsigned, PromotedArg> &promoted) {
+    std::vector<Type *> params;
+    for (auto &arg : func->get_args()) {
+        auto iter = promoted.find(arg.get_arg_no());
+        if (iter == promoted.end()) {
+            params.push_back(arg.get_type());
+            continue;
+        }
+        auto elem_type =
+            static_cast<PointerType *>(arg.get_type())->get_element_type();
+        params.insert(params.end(), iter->second.loads.size(), elem_type);
+    }
+    auto new_func = Function::create(
+        m_->get_function_type(func->get_return_type(), params),
+        func->get_name(), m_);
+    auto &funcs = m_->get_functions();
+    funcs.remove(new_func);
+    funcs.insert(func->getIterator(), new_func);
+
+    // 被提升的形参不建立映射，副本中读取它的 load 改为使用新的标量形参
+    std::map<Value *, Value *> v_map;
+    std::map<LoadInst *, Value *> load_map;
+    auto new_arg = new_func->get_args().begin();
+    for (auto &arg : func->get_args()) {
+        auto iter = promoted.find(arg.get_arg_no());
+        if (iter == promoted.end()) {
+            v_map[&arg] = &*new_arg++;
+            continue;
+        }
+        for (auto &[idx, loads] : iter->second.loads) {
+            for (auto load : loads)
+                load_map[load] = &*new_arg;
+            new_arg++;
+        }
+    }
+    clone_function_body(func, new_func, v_map);
+    for (auto [load, val] : load_map) {
+        auto load_new = static_cast<Instruction *>(v_map[load]);
+        load_new->replace_all_use_with(val);
+        load_new->get_parent()->erase_instr(load_new);
+    }
+    for (auto &[arg_no, info] : promoted) {
+        for (auto gep : info.geps) {
+            auto gep_new = static_cast<Instruction *>(v_map[gep]);
+            gep_new->get_parent()->erase_instr(gep_new);
+        }
+    }
+
+    // 在调用点读取被提升的元素；原函数体中的递归调用随原函数一起删除
+    std::vector<CallInst *> calls;
+    for (auto &use : func->get_use_list()) {
+        auto call = static_cast<CallInst *>(use.val_);
+        if (call->get_function() != func)
+            calls.push_back(call);
+    }
+    for (auto call : calls) {
+        auto bb = call->get_parent();
+        auto insert_before_call = [&](Instruction *inst) {
+            bb->remove_instr(inst);
+            bb->insert_before(call->getIterator(), inst);
+        };
+        std::vector<Value *> args;
+        for (unsigned i = 0; i < func->get_num_of_args(); i++) {
+            auto actual = call->get_operand(i + 1);
+            auto iter = promoted.find(i);
+            if (iter == promoted.end()) {
+                args.push_back(actual);
+                continue;
+            }
+            for (auto &[idx, loads] : iter->second.loads) {
+                auto gep = GetElementPtrInst::create_gep(
+                    actual, {ConstantInt::get(idx, m_)}, bb);
+                insert_before_call(gep);
+                auto load = LoadInst::create_load(gep, bb);
+                insert_before_call(load);
+                args.push_back(load);
+            }
+        }
+        auto new_call = CallInst::create_call(new_func, args, bb);
+        insert_before_call(new_call);
+        call->replace_all_use_with(new_call);
+        bb->erase_instr(call);
+    }
+    LOG_INFO << "promote array arguments of " << func->get_name();
+    erase_function(func);
+}
@@ -0,0 +1,126 @@
+#include "AutoMemoize.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "logging.hpp"
+
+void AutoMemoize::run() {
+    CallGraph call_graph(m_);
+    call_graph.run();
+    FuncInfo func_info(m_);
+    func_info.run();
+
+    std::vector<Function *> candidates;
+    for (auto &f : m_->get_functions()) {
+        if (candidates.size() < max_tables and
+            is_candidate(&f, call_graph, func_info))
+            candidates.push_back(&f);
+    }
+    for (unsigned i = 0; i < candidates.size(); i++)
+        memoize(candidates[i], i);
+    LOG_INFO << "auto memoize: memoized " << candidates.size()
+             << " functions";
+}
+
+bool AutoMemoize::is_candidate(Function *func, CallGraph &call_graph,
+                               FuncInfo &func_info) {
+    if (func->is_declaration() or func->get_name() == "main")
+        return false;
+    auto ret_type = func->get_return_type();
+    if (not ret_type->is_int32_type() and not ret_type->is_float_type())
+        return false;
+    if (func->get_num_of_args() == 0 or func->get_num_of_args() > max_keys)
+        return false;
+    for (auto &arg : func->get_args()) {
+        if (not arg.get_type()->is_int32_type() and
+            not arg.get_type()->is_float_type())
+            return false;
+    }
+    if (not func_info.is_readnone(func))
+        return false;
+    // 只有多路递归才有重复的子问题，单路递归记忆化只增加开销
+    unsigned recursive_calls = 0;
+    for (auto call : call_graph.get_call_sites(func)) {
+        if (call->get_operand(0) == func)
+            recursive_calls++;
+    }
+    return recursive_calls >= 2;
+}
+
+void AutoMemoize::memoize(Function *func, int table) {
+    auto is_float = func->get_return_type()->is_float_type();
+    auto int_type = m_->get_int32_type();
+    auto void_type = m_->get_void_type();
+    auto lookup = get_runtime("memo_lookup", int_type, {int_type});
+    auto get_result =
+        is_float ? get_runtime("memo_result_float", m_->get_float_type(), {})
+                 : get_runtime("memo_result_int", int_type, {});
+    auto store =
+        is_float
+            ? get_runtime("memo_store_float", void_type,
+                          {int_type, m_->get_float_type()})
+            : get_runtime("memo_store_int", void_type, {int_type, int_type});
+
+    std::vector<ReturnInst *> rets;
+    for (auto &bb : func->get_basic_blocks()) {
+        if (auto ret = dynamic_cast<ReturnInst *>(bb.get_terminator()))
+            rets.push_back(ret);
+    }
+
+    // 入口块只保留 alloca，其余指令移入原函数体的新入口
+    auto entry = func->get_entry_block();
+    auto body = BasicBlock::create(m_, "", func);
+    std::vector<Instruction *> moved;
+    for (auto &inst : entry->get_instructions()) {
+        if (not inst.is_alloca())
+            moved.push_back(&inst);
+    }
+    for (auto inst : moved) {
+        entry->remove_instr(inst);
+        body->add_instruction(inst);
+        inst->set_parent(body);
+    }
+
+    // 命中时直接返回缓存的结果
+    auto table_id = ConstantInt::get(table, m_);
+    auto hit_bb = BasicBlock::create(m_, "", func);
+    emit_keys(func, entry);
+    auto hit = CallInst::create_call(lookup, {table_id}, entry);
+    auto cond = ICmpInst::create_ne(hit, ConstantInt::get(0, m_), entry);
+    BranchInst::create_cond_br(cond, hit_bb, body, entry);
+    ReturnInst::create_ret(CallInst::create_call(get_result, {}, hit_bb),
+                           hit_bb);
+    // 移动的跳转指令仍以入口块为前驱，重建 CFG 并修正后继块的 phi
+    func->reset_bbs();
+    body->redirect_succ_phis(entry);
+
+    // 每个返回前写入缓存
+    for (auto ret : rets) {
+        auto bb = ret->get_parent();
+        bb->remove_instr(ret);
+        emit_keys(func, bb);
+        CallInst::create_call(store, {table_id, ret->get_operand(0)}, bb);
+        bb->add_instruction(ret);
+    }
+    LOG_INFO << "memoize " << func->get_name() << " with table " << table;
+}
+
+void AutoMemoize::emit_keys(Function *func, BasicBlock *bb) {
+    for (auto &arg : func->get_args()) {
+        auto key = arg.get_type()->is_float_type()
+                       ? get_runtime("memo_key_float", m_->get_void_type(),
+                                     {m_->get_float_type()})
+                       : get_runtime("memo_key_int", m_->get_void_type(),
+                                     {m_->get_int32_type()});
+        CallInst::create_call(key, {&arg}, bb);
+    }
+}
+
+Function *AutoMemoize::get_runtime(const std::string &name, Type *ret_type,
+                                   std::vector<Type *> params) {
+    for (auto &f : m_->get_functions()) {
+        if (f.get_name() == name)
+            return &f;
+    }
+    return Function::create(m_->get_function_type(ret_type, params), name,
+                            m_);
+}
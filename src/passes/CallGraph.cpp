@@ -0,0 +1,69 @@
+#include "CallGraph.hpp"
+
+#include <algorithm>
+
+void CallGraph::run() {
+    nodes_.clear();
+    sccs_.clear();
+    stack_.clear();
+    dfn_count_ = 0;
+    for (auto &f : m_->get_functions())
+        nodes_[&f];
+    for (auto &f : m_->get_functions()) {
+        auto &node = nodes_[&f];
+        for (auto &bb : f.get_basic_blocks()) {
+            for (auto &inst : bb.get_instructions()) {
+                if (not inst.is_call())
+                    continue;
+                auto callee = static_cast<Function *>(inst.get_operand(0));
+                node.call_sites.push_back(static_cast<CallInst *>(&inst));
+                if (std::find(node.callees.begin(), node.callees.end(),
+                              callee) != node.callees.end())
+                    continue;
+                node.callees.push_back(callee);
+                nodes_[callee].callers.push_back(&f);
+            }
+        }
+    }
+    for (auto &f : m_->get_functions()) {
+        if (nodes_[&f].dfn < 0)
+            tarjan(&f);
+    }
+}
+
+// 分量在其所有后继分量之后出栈，因此 sccs_ 天然是自底向上的顺序
+void CallGraph::tarjan(Function *func) {
+    auto &node = nodes_[func];
+    node.dfn = node.low = dfn_count_++;
+    node.on_stack = true;
+    stack_.push_back(func);
+    for (auto callee : node.callees) {
+        auto &succ = nodes_[callee];
+        if (succ.dfn < 0) {
+            tarjan(callee);
+            node.low = std::min(node.low, succ.low);
+        } else if (succ.on_stack) {
+            node.low = std::min(node.low, succ.dfn);
+        }
+    }
+    if (node.low != node.dfn)
+        return;
+    SCC scc;
+    Function *member;
+    do {
+        member = stack_.back();
+        stack_.pop_back();
+        nodes_[member].on_stack = false;
+        nodes_[member].scc = sccs_.size();
+        scc.push_back(member);
+    } while (member != func);
+    sccs_.push_back(std::move(scc));
+}
+
+bool CallGraph::is_recursive(Function *func) {
+    auto &node = nodes_.at(func);
+    if (sccs_[node.scc].size() > 1)
+        return true;
+    return std::find(node.callees.begin(), node.callees.end(), func) !=
+           node.callees.end();
+}
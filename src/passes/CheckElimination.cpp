@@ -0,0 +1,263 @@
+#include "CheckElimination.hpp"
+#include "BasicBlock.hpp"
+#include "ConstFolder.hpp"
+#include "Constant.hpp"
+#include "logging.hpp"
+
+#include <algorithm>
+
+// 递归求范围的深度上限，超过时保守地返回全集
+static constexpr unsigned MAX_DEPTH = 16;
+
+static bool is_empty(long long lo, long long hi) { return lo > hi; }
+
+void CheckElimination::run() {
+    loop_detection_ = std::make_unique<LoopDetection>(m_);
+    unsigned count = 0;
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration())
+            continue;
+        count += run_on_func(&f);
+    }
+    LOG_INFO << "check elimination removed " << count
+             << " negative-index checks";
+}
+
+unsigned CheckElimination::run_on_func(Function *f) {
+    loop_detection_->run_on_func(f);
+    dominators_ = loop_detection_->get_dominators();
+    phi_range_.clear();
+    phi_log_.clear();
+
+    std::vector<BranchInst *> checks;
+    for (auto &bb : f->get_basic_blocks()) {
+        if (dominators_->get_idom(&bb) == nullptr)
+            continue; // 不可达的基本块
+        auto br = dynamic_cast<BranchInst *>(bb.get_terminator());
+        if (br == nullptr or not br->is_cond_br())
+            continue;
+        auto cmp = dynamic_cast<ICmpInst *>(br->get_condition());
+        if (cmp == nullptr or cmp->get_instr_type() != Instruction::lt)
+            continue;
+        auto zero = dynamic_cast<ConstantInt *>(cmp->get_operand(1));
+        // 源程序中的 x < 0 不是下标检查，其分支内可能还有嵌套的区域
+        if (zero != nullptr and zero->get_value() == 0 and
+            is_except_block(br->get_operand(1)->as<BasicBlock>()))
+            checks.push_back(br);
+    }
+    unsigned count = 0;
+    for (auto br : checks)
+        count += fold_check(br);
+    return count;
+}
+
+bool CheckElimination::is_except_block(BasicBlock *bb) {
+    auto &insts = bb->get_instructions();
+    if (insts.empty() or not insts.front().is_call())
+        return false;
+    auto callee = insts.front().get_operand(0);
+    return callee->get_name() == "neg_idx_except";
+}
+
+bool CheckElimination::fold_check(BranchInst *br) {
+    auto bb = br->get_parent();
+    auto idx = br->get_condition()->as<Instruction>()->get_operand(0);
+    auto except_bb = br->get_operand(1)->as<BasicBlock>();
+    auto ok_bb = br->get_operand(2)->as<BasicBlock>();
+    if (except_bb == ok_bb or get_range(idx, bb).lo < 0)
+        return false;
+
+    // 改为无条件跳转，BranchInst 的析构会维护前驱后继关系。
+    // 内联后异常块可能跳转到带 phi 的返回块，不可达的异常块交给 DeadCode 删除
+    bb->erase_instr(br);
+    BranchInst::create_br(ok_bb, bb);
+    return true;
+}
+
+CheckElimination::Range CheckElimination::get_range(Value *val, BasicBlock *bb,
+                                                    unsigned depth) {
+    if (depth > MAX_DEPTH)
+        return {};
+    return refine(val, get_def_range(val, bb, depth), bb, depth);
+}
+
+CheckElimination::Range
+CheckElimination::get_def_range(Value *val, BasicBlock *bb, unsigned depth) {
+    if (auto c = dynamic_cast<ConstantInt *>(val))
+        return {c->get_value(), c->get_value()};
+    auto inst = dynamic_cast<Instruction *>(val);
+    if (inst == nullptr or not inst->get_type()->is_int32_type())
+        return {};
+    if (inst->is_phi())
+        return get_phi_range(static_cast<PhiInst *>(inst), depth);
+    if (inst->is_zext())
+        return {0, 1};
+    if (not inst->isBinary() or inst->get_type()->is_float_type())
+        return {};
+
+    auto a = get_range(inst->get_operand(0), bb, depth + 1);
+    auto b = get_range(inst->get_operand(1), bb, depth + 1);
+    if (is_empty(a.lo, a.hi) or is_empty(b.lo, b.hi))
+        return {1, 0};
+    long long lo, hi;
+    switch (inst->get_instr_type()) {
+    case Instruction::add:
+        lo = a.lo + b.lo, hi = a.hi + b.hi;
+        break;
+    case Instruction::sub:
+        lo = a.lo - b.hi, hi = a.hi - b.lo;
+        break;
+    case Instruction::mul:
+    case Instruction::sdiv: {
+        // 除数区间不含 0 时，商在四个端点处取得最值
+        if (inst->is_div() and b.lo <= 0 and b.hi >= 0)
+            return {};
+        long long corners[4];
+        unsigned n = 0;
+        for (auto x : {a.lo, a.hi})
+            for (auto y : {b.lo, b.hi})
+                corners[n++] = inst->is_mul() ? x * y : x / y;
+        lo = *std::min_element(corners, corners + 4);
+        hi = *std::max_element(corners, corners + 4);
+        break;
+    }
+    default:
+        return {};
+    }
+    // 可能发生 32 位溢出回绕时结果不可预测
+    if (lo < INT_MIN or hi > INT_MAX)
+        return {};
+    return {lo, hi};
+}
+
+CheckElimination::Range CheckElimination::get_phi_range(PhiInst *phi,
+                                                        unsigned depth) {
+    auto it = phi_range_.find(phi);
+    if (it != phi_range_.end())
+        return it->second;
+    auto loop = loop_detection_->get_loop_of(phi->get_parent());
+    if (loop != nullptr and loop->get_header() == phi->get_parent())
+        return get_iv_range(phi, loop, depth);
+
+    // 先记为全集，防止递归求值时成环
+    phi_range_[phi] = {};
+    phi_log_.push_back(phi);
+    Range range{1, 0};
+    for (auto [val, pred] : phi->get_phi_pairs()) {
+        auto r = get_range(val, pred, depth + 1);
+        range.lo = std::min(range.lo, r.lo);
+        range.hi = std::max(range.hi, r.hi);
+    }
+    phi_range_[phi] = range;
+    return range;
+}
+
+// 循环头中的 phi：先假设其值不低于（或不高于）进入循环时的初值，
+// 若沿回边流入的值在该假设下仍满足假设，则假设成立
+CheckElimination::Range
+CheckElimination::get_iv_range(PhiInst *phi, Loop *loop, unsigned depth) {
+    Range init{1, 0};
+    for (auto [val, pred] : phi->get_phi_pairs()) {
+        if (loop->contains(pred))
+            continue;
+        auto r = get_range(val, pred, depth + 1);
+        init.lo = std::min(init.lo, r.lo);
+        init.hi = std::max(init.hi, r.hi);
+    }
+    if (not is_empty(init.lo, init.hi)) {
+        for (Range assumption : {Range{init.lo, INT_MAX},
+                                 Range{INT_MIN, init.hi}}) {
+            auto marker = phi_log_.size();
+            phi_range_[phi] = assumption;
+            phi_log_.push_back(phi);
+            Range next{1, 0};
+            for (auto [val, pred] : phi->get_phi_pairs()) {
+                if (not loop->contains(pred))
+                    continue;
+                auto r = get_range(val, pred, depth + 1);
+                next.lo = std::min(next.lo, r.lo);
+                next.hi = std::max(next.hi, r.hi);
+            }
+            if (next.lo >= assumption.lo and next.hi <= assumption.hi) {
+                Range range{std::min(init.lo, next.lo),
+                            std::max(init.hi, next.hi)};
+                phi_range_[phi] = range;
+                return range;
+            }
+            // 假设不成立，撤销在该假设下得到的所有结果
+            while (phi_log_.size() > marker) {
+                phi_range_.erase(phi_log_.back());
+                phi_log_.pop_back();
+            }
+        }
+    }
+    phi_range_[phi] = {};
+    phi_log_.push_back(phi);
+    return {};
+}
+
+CheckElimination::Range CheckElimination::refine(Value *val, Range range,
+                                                 BasicBlock *bb,
+                                                 unsigned depth) {
+    // 若 cur 只有唯一前驱且经条件分支到达，则该条件在 cur 支配的所有块中成立
+    for (auto cur = bb; cur != nullptr;) {
+        auto &preds = cur->get_pre_basic_blocks();
+        auto br = preds.size() == 1
+                      ? dynamic_cast<BranchInst *>(
+                            preds.front()->get_terminator())
+                      : nullptr;
+        if (br != nullptr and br->is_cond_br() and
+            br->get_operand(1) != br->get_operand(2)) {
+            bool taken = br->get_operand(1) == cur;
+            Value *cond = br->get_condition();
+            // 兼容 icmp ne/eq (zext cmp), 0 的形式
+            auto cmp = dynamic_cast<ICmpInst *>(cond);
+            if (cmp != nullptr and (cmp->get_instr_type() == Instruction::ne or
+                                    cmp->get_instr_type() == Instruction::eq)) {
+                auto zero = dynamic_cast<ConstantInt *>(cmp->get_operand(1));
+                auto zext = dynamic_cast<ZextInst *>(cmp->get_operand(0));
+                if (zero != nullptr and zero->get_value() == 0 and
+                    zext != nullptr) {
+                    if (cmp->get_instr_type() == Instruction::eq)
+                        taken = not taken;
+                    cmp = dynamic_cast<ICmpInst *>(zext->get_operand(0));
+                }
+            }
+            if (cmp != nullptr and
+                (cmp->get_operand(0) == val or cmp->get_operand(1) == val)) {
+                auto op = cmp->get_instr_type();
+                if (not taken)
+                    op = ConstFolder::invert_predicate(op);
+                auto other = cmp->get_operand(1);
+                if (cmp->get_operand(1) == val) {
+                    op = ConstFolder::swap_predicate(op);
+                    other = cmp->get_operand(0);
+                }
+                auto r = get_range(other, preds.front(), depth + 1);
+                switch (op) {
+                case Instruction::lt:
+                    range.hi = std::min(range.hi, r.hi - 1);
+                    break;
+                case Instruction::le:
+                    range.hi = std::min(range.hi, r.hi);
+                    break;
+                case Instruction::gt:
+                    range.lo = std::max(range.lo, r.lo + 1);
+                    break;
+                case Instruction::ge:
+                    range.lo = std::max(range.lo, r.lo);
+                    break;
+                case Instruction::eq:
+                    range.lo = std::max(range.lo, r.lo);
+                    range.hi = std::min(range.hi, r.hi);
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+        auto idom = dominators_->get_idom(cur);
+        cur = idom == cur ? nullptr : idom;
+    }
+    return range;
+}
@@ -0,0 +1,71 @@
+#include "CloneFunction.hpp"
+#include "BasicBlock.hpp"
+#include "Instruction.hpp"
+
+#include <vector>
+
+Function *clone_function(Function *func, const std::string &name,
+                         std::map<Value *, Value *> &v_map) {
+    auto module = func->get_parent();
+    auto clone = Function::create(func->get_function_type(), name, module);
+    auto clone_arg = clone->get_args().begin();
+    for (auto &arg : func->get_args())
+        v_map[&arg] = &*clone_arg++;
+    clone_function_body(func, clone, v_map);
+    return clone;
+}
+
+void clone_function_body(Function *func, Function *clone,
+                         std::map<Value *, Value *> &v_map) {
+    auto module = func->get_parent();
+    for (auto &bb : func->get_basic_blocks())
+        v_map[&bb] = BasicBlock::create(
+            module, &bb == func->get_entry_block() ? "entry" : "", clone);
+
+    std::vector<Instruction *> new_insts;
+    for (auto &bb : func->get_basic_blocks()) {
+        auto bb_new = static_cast<BasicBlock *>(v_map[&bb]);
+        for (auto &inst : bb.get_instructions()) {
+            Instruction *inst_new;
+            // CallInst::clone 不复制实参，void ret 没有操作数可供 clone
+            if (inst.is_call()) {
+                inst_new = CallInst::create_call(
+                    static_cast<Function *>(inst.get_operand(0)),
+                    {inst.get_operands().begin() + 1,
+                     inst.get_operands().end()},
+                    bb_new);
+            } else if (inst.is_ret() and
+                       (static_cast<ReturnInst *>(&inst)->is_void_ret() or
+                        clone->get_return_type()->is_void_type())) {
+                inst_new = ReturnInst::create_void_ret(bb_new);
+            } else {
+                inst_new = inst.clone(bb_new);
+                if (inst.is_phi())
+                    bb_new->add_instruction(inst_new);
+            }
+            v_map[&inst] = inst_new;
+            new_insts.push_back(inst_new);
+        }
+    }
+    for (auto inst : new_insts) {
+        for (unsigned i = 0; i < inst->get_num_operand(); i++) {
+            auto iter = v_map.find(inst->get_operand(i));
+            if (iter != v_map.end())
+                inst->set_operand(i, iter->second);
+        }
+    }
+    // 复制的跳转指令在构造时连接到了原函数的基本块
+    func->reset_bbs();
+    clone->reset_bbs();
+}
+
+void erase_function(Function *func) {
+    // 跳转指令的析构需要读取目标基本块，它只引用函数内的值，保留其操作数
+    for (auto &bb : func->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            if (not inst.is_br())
+                inst.remove_all_operands();
+        }
+    }
+    func->get_parent()->get_functions().erase(func->getIterator());
+}
@@ -2,92 +2,6 @@
 #include "Instruction.hpp"
 #include "logging.hpp"
 
-// 计算整数二元运算的常量折叠
-ConstantInt *ConstFolder::compute(Instruction::OpID op, ConstantInt *value1,
-                                  ConstantInt *value2) {
-    int c_value1 = value1->get_value();
-    int c_value2 = value2->get_value();
-    switch (op) {
-    case Instruction::add:
-        return ConstantInt::get(c_value1 + c_value2, module_);
-    case Instruction::sub:
-        return ConstantInt::get(c_value1 - c_value2, module_);
-    case Instruction::mul:
-        return ConstantInt::get(c_value1 * c_value2, module_);
-    case Instruction::sdiv:
-        return c_value2 != 0 ? ConstantInt::get(c_value1 / c_value2, module_)
-                             : nullptr;
-    case Instruction::eq:
-        return ConstantInt::get(c_value1 == c_value2, module_);
-    case Instruction::ne:
-        return ConstantInt::get(c_value1 != c_value2, module_);
-    case Instruction::gt:
-        return ConstantInt::get(c_value1 > c_value2, module_);
-    case Instruction::ge:
-        return ConstantInt::get(c_value1 >= c_value2, module_);
-    case Instruction::lt:
-        return ConstantInt::get(c_value1 < c_value2, module_);
-    case Instruction::le:
-        return ConstantInt::get(c_value1 <= c_value2, module_);
-    default:
-        return nullptr;
-    }
-}
-
-// 计算浮点二元运算的常量折叠
-ConstantFP *ConstFolder::compute(Instruction::OpID op, ConstantFP *value1,
-                                 ConstantFP *value2) {
-    float c_value1 = value1->get_value();
-    float c_value2 = value2->get_value();
-    switch (op) {
-    case Instruction::fadd:
-        return ConstantFP::get(c_value1 + c_value2, module_);
-    case Instruction::fsub:
-        return ConstantFP::get(c_value1 - c_value2, module_);
-    case Instruction::fmul:
-        return ConstantFP::get(c_value1 * c_value2, module_);
-    case Instruction::fdiv:
-        return c_value2 != 0.0f ? ConstantFP::get(c_value1 / c_value2, module_)
-                                : nullptr;
-    case Instruction::feq:
-        return ConstantFP::get(c_value1 == c_value2, module_);
-    case Instruction::fne:
-        return ConstantFP::get(c_value1 != c_value2, module_);
-    case Instruction::fgt:
-        return ConstantFP::get(c_value1 > c_value2, module_);
-    case Instruction::fge:
-        return ConstantFP::get(c_value1 >= c_value2, module_);
-    case Instruction::flt:
-        return ConstantFP::get(c_value1 < c_value2, module_);
-    case Instruction::fle:
-        return ConstantFP::get(c_value1 <= c_value2, module_);
-    default:
-        return nullptr;
-    }
-}
-
-// 计算整数到浮点的类型转换
-ConstantFP *ConstFolder::compute(Instruction::OpID op, ConstantInt *value1) {
-    int c_value1 = value1->get_value();
-    switch (op) {
-    case Instruction::sitofp:
-        return ConstantFP::get(static_cast<float>(c_value1), module_);
-    default:
-        return nullptr;
-    }
-}
-
-// 计算浮点到整数的类型转换
-ConstantInt *ConstFolder::compute(Instruction::OpID op, ConstantFP *value1) {
-    float c_value1 = value1->get_value();
-    switch (op) {
-    case Instruction::fptosi:
-        return ConstantInt::get(static_cast<int>(c_value1), module_);
-    default:
-        return nullptr;
-    }
-}
-
 // 尝试将 Value 转换为 ConstantFP
 ConstantFP *cast_constantfp(Value *value) {
     auto constant_fp_ptr = dynamic_cast<ConstantFP *>(value);
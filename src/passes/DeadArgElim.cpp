@@ -0,0 +1,114 @@
+#include "DeadArgElim.hpp"
+#include "BasicBlock.hpp"
+#include "CloneFunction.hpp"
+#include "logging.hpp"
+
+#include <map>
+
+void DeadArgElim::run() {
+    unsigned arg_count = 0, ret_count = 0;
+    bool changed;
+    // 删除参数后，被删除的实参可能使调用者的形参也变为无用
+    do {
+        changed = false;
+        std::vector<std::pair<Function *, std::vector<bool>>> work_list;
+        for (auto &f : m_->get_functions()) {
+            if (f.is_declaration() or f.get_name() == "main")
+                continue;
+            std::vector<bool> dead_args;
+            bool any_dead = is_dead_return(&f);
+            for (auto &arg : f.get_args()) {
+                dead_args.push_back(is_dead_arg(&arg));
+                any_dead = any_dead or dead_args.back();
+            }
+            if (any_dead)
+                work_list.push_back({&f, dead_args});
+        }
+        for (auto &[func, dead_args] : work_list) {
+            bool dead_ret = is_dead_return(func);
+            for (auto dead : dead_args)
+                arg_count += dead;
+            ret_count += dead_ret;
+            rewrite_function(func, dead_args, dead_ret);
+            changed = true;
+        }
+    } while (changed);
+    LOG_INFO << "dead argument elimination removed " << arg_count
+             << " arguments and " << ret_count << " return values";
+}
+
+bool DeadArgElim::is_dead_arg(Argument *arg) {
+    auto func = arg->get_parent();
+    for (auto &use : arg->get_use_list()) {
+        auto call = dynamic_cast<CallInst *>(use.val_);
+        if (call == nullptr or call->get_operand(0) != func or
+            use.arg_no_ != arg->get_arg_no() + 1)
+            return false;
+    }
+    return true;
+}
+
+bool DeadArgElim::is_dead_return(Function *func) {
+    if (func->get_return_type()->is_void_type())
+        return false;
+    for (auto &use : func->get_use_list()) {
+        auto call = dynamic_cast<CallInst *>(use.val_);
+        if (call == nullptr or use.arg_no_ != 0)
+            return false;
+        for (auto &call_use : call->get_use_list()) {
+            auto ret = dynamic_cast<ReturnInst *>(call_use.val_);
+            if (ret == nullptr or ret->get_function() != func)
+                return false;
+        }
+    }
+    return true;
+}
+
+void DeadArgElim::rewrite_function(Function *func,
+                                   const std::vector<bool> &dead_args,
+                                   bool dead_ret) {
+    std::vector<Type *> params;
+    for (auto &arg : func->get_args()) {
+        if (not dead_args[arg.get_arg_no()])
+            params.push_back(arg.get_type());
+    }
+    auto ret_type = dead_ret ? m_->get_void_type() : func->get_return_type();
+    auto new_func = Function::create(m_->get_function_type(ret_type, params),
+                                     func->get_name(), m_);
+    // 新函数放在原函数的位置，保持输出顺序
+    auto &funcs = m_->get_functions();
+    funcs.remove(new_func);
+    funcs.insert(func->getIterator(), new_func);
+
+    std::map<Value *, Value *> v_map;
+    auto new_arg = new_func->get_args().begin();
+    for (auto &arg : func->get_args()) {
+        if (not dead_args[arg.get_arg_no()])
+            v_map[&arg] = &*new_arg++;
+    }
+    clone_function_body(func, new_func, v_map);
+
+    // 原函数体中的递归调用随原函数一起删除，不需要改写
+    std::vector<CallInst *> calls;
+    for (auto &use : func->get_use_list()) {
+        auto call = static_cast<CallInst *>(use.val_);
+        if (call->get_function() != func)
+            calls.push_back(call);
+    }
+    for (auto call : calls) {
+        std::vector<Value *> args;
+        for (unsigned i = 0; i < dead_args.size(); i++) {
+            if (not dead_args[i])
+                args.push_back(call->get_operand(i + 1));
+        }
+        auto bb = call->get_parent();
+        auto new_call = CallInst::create_call(new_func, args, bb);
+        bb->remove_instr(new_call);
+        bb->insert_before(call->getIterator(), new_call);
+        if (not dead_ret)
+            call->replace_all_use_with(new_call);
+        bb->erase_instr(call);
+    }
+
+    erase_function(func);
+}
@@ -1,17 +1,24 @@
 #include "DeadCode.hpp"
 #include "logging.hpp"
+
+#include <cassert>
+#include <functional>
 #include <vector>
 
 // 处理流程：两趟处理，mark 标记有用变量，sweep 删除无用指令
 void DeadCode::run() {
     bool changed{};
     func_info->run();
+    if (aggressive_)
+        post_dominators_ = std::make_unique<PostDominators>(m_);
     do {
         changed = false;
         for (auto &F : m_->get_functions()) {
             auto func = &F;
             changed |= clear_basic_blocks(func);
             mark(func);
+            if (aggressive_)
+                changed |= rewrite_dead_branches(func);
             changed |= sweep(func);
         }
         sweep_globally();
@@ -30,6 +37,13 @@ bool DeadCode::clear_basic_blocks(Function *func) {
         }
     }
     for (auto bb : to_erase) {
+        // 删除后继块 phi 中来自该块的参数
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            for (auto &inst : succ->get_instructions()) {
+                if (inst.is_phi())
+                    static_cast<PhiInst *>(&inst)->remove_phi_operand(bb);
+            }
+        }
         bb->erase_from_parent();
     }
     return changed;
@@ -38,19 +52,22 @@ bool DeadCode::clear_basic_blocks(Function *func) {
 void DeadCode::mark(Function *func) {
     work_list.clear();
     marked.clear();
+    live_bbs_.clear();
+    if (aggressive_ and not func->is_declaration()) {
+        post_dominators_->run_on_func(func);
+        mark_loop_branches(func);
+    }
     // 标记所有关键指令
     for (auto &bb : func->get_basic_blocks()) {
         for (auto &ins : bb.get_instructions()) {
-            if (is_critical(&ins)) {
-                marked[&ins] = true;
-                work_list.push_back(&ins);
-            }
+            if (is_critical(&ins))
+                mark_live(&ins);
         }
     }
     // 工作列表算法，标记所有依赖关键指令的指令
     while (!work_list.empty()) {
-        auto ins = work_list.front();
-        work_list.pop_front();
+        auto ins = work_list.back();
+        work_list.pop_back();
         mark(ins);
     }
 }
@@ -67,6 +84,85 @@ void DeadCode::mark(Instruction *ins) {
         marked[def] = true;
         work_list.push_back(def);
     }
+    if (not aggressive_)
+        return;
+    // 块中有有用的指令时，该块控制依赖的分支也有用
+    auto bb = ins->get_parent();
+    if (live_bbs_.insert(bb).second) {
+        for (auto dep : post_dominators_->get_reverse_dominance_frontier(bb))
+            mark_live(dep->get_terminator());
+    }
+    // 有用的 phi 需要保留到达它的每条边
+    if (ins->is_phi()) {
+        for (auto pred : bb->get_pre_basic_blocks())
+            mark_live(pred->get_terminator());
+    }
+}
+
+void DeadCode::mark_live(Instruction *ins) {
+    if (marked[ins])
+        return;
+    marked[ins] = true;
+    work_list.push_back(ins);
+}
+
+// 回边上的分支与无法到达返回块的块的终结指令始终有用，保证不会删除（死）循环
+void DeadCode::mark_loop_branches(Function *func) {
+    std::unordered_set<BasicBlock *> visited, on_stack;
+    std::function<void(BasicBlock *)> dfs = [&](BasicBlock *bb) {
+        visited.insert(bb);
+        on_stack.insert(bb);
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            if (on_stack.count(succ))
+                mark_live(bb->get_terminator());
+            else if (not visited.count(succ))
+                dfs(succ);
+        }
+        on_stack.erase(bb);
+    };
+    dfs(func->get_entry_block());
+    for (auto &bb : func->get_basic_blocks()) {
+        if (not post_dominators_->reaches_return(&bb))
+            mark_live(bb.get_terminator());
+    }
+}
+
+// 无用的分支与其最近的有用后必经块之间没有有用的指令，直接跳转过去
+bool DeadCode::rewrite_dead_branches(Function *func) {
+    if (func->is_declaration())
+        return false;
+    bool changed = false;
+    for (auto &bb : func->get_basic_blocks()) {
+        auto term = bb.get_terminator();
+        if (marked[term])
+            continue;
+        auto target = post_dominators_->get_ipdom(&bb);
+        while (target != nullptr and not live_bbs_.count(target))
+            target = post_dominators_->get_ipdom(target);
+        // 返回块总是有用的，连向虚拟出口的其他块的终结指令也已被标记
+        assert(target != nullptr && "dead branch without live post-dominator");
+        auto br = static_cast<BranchInst *>(term);
+        if (not br->is_cond_br() and br->get_operand(0) == target) {
+            marked[term] = true;
+            continue;
+        }
+        // 被跳过的后继中的 phi 都是无用的，否则该分支会被标记为有用
+        std::vector<BasicBlock *> old_succs(bb.get_succ_basic_blocks().begin(),
+                                            bb.get_succ_basic_blocks().end());
+        bb.erase_instr(term);
+        for (auto succ : old_succs) {
+            if (succ == target)
+                continue;
+            for (auto &inst : succ->get_instructions()) {
+                if (not inst.is_phi())
+                    break;
+                static_cast<PhiInst *>(&inst)->remove_phi_operand(&bb);
+            }
+        }
+        marked[BranchInst::create_br(target, &bb)] = true;
+        changed = true;
+    }
+    return changed;
 }
 
 bool DeadCode::sweep(Function *func) {
@@ -99,9 +195,9 @@ bool DeadCode::sweep(Function *func) {
 bool DeadCode::is_critical(Instruction *ins) {
     // 判断指令是否关键（即不能被删除）
     if (ins->is_call()) {
-        // 函数调用：如果函数有副作用（非纯函数），则关键
+        // 函数调用：可能写非局部内存、有输入输出或可能不返回时关键，只读函数的调用可以删除
         auto called_func = dynamic_cast<Function *>(ins->get_operand(0));
-        if (called_func && !func_info->is_pure_function(called_func)) {
+        if (called_func && !func_info->is_readonly(called_func)) {
             return true;
         }
     } else if (ins->is_store()) {
@@ -111,12 +207,12 @@ bool DeadCode::is_critical(Instruction *ins) {
         // 返回指令：关键
         return true;
     } else if (ins->is_br()) {
-        // 分支指令：影响控制流，视为关键
-        return true;
+        // 分支指令：影响控制流，视为关键；激进模式下由控制依赖决定
+        return not aggressive_;
     } else if (ins->is_phi()) {
-        // PHI 指令：涉及控制流合并，视为关键
-        return true;
-    } else if (!ins->get_use_list().empty()) {
+        // PHI 指令：涉及控制流合并，视为关键；激进模式下由使用者决定
+        return not aggressive_;
+    } else if (not aggressive_ && !ins->get_use_list().empty()) {
         // 如果指令的结果被其他指令使用，则关键
         return true;
     }
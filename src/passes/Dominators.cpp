@@ -15,15 +15,19 @@ void Dominators::run() {
 void Dominators::run_on_func(Function *f) {
     dom_post_order_.clear();
     dom_dfs_order_.clear();
+    post_order_vec_.clear();
+    // 允许在 CFG 变化后对同一函数重新分析，需清除上一次的结果
     for(auto &bb1 : f->get_basic_blocks()) {
         auto bb = &bb1;
-        idom_.insert({bb, nullptr});
-        dom_frontier_.insert({bb, {}});
-        dom_tree_succ_blocks_.insert({bb, {}});
+        idom_[bb] = nullptr;
+        dom_frontier_[bb].clear();
+        dom_tree_succ_blocks_[bb].clear();
+        post_order_.erase(bb);
+        dom_tree_level_.erase(bb);
     }
+    frontier_ready_.erase(f);
     create_reverse_post_order(f);
     create_idom(f);
-    create_dominance_frontier(f);
     create_dom_tree_succ(f);
     create_dom_dfs_order(f);
 }
@@ -53,7 +57,7 @@ void Dominators::dfs(BasicBlock *bb, std::set<BasicBlock *> &visited) {
         }
     }
     post_order_vec_.push_back(bb);
-    post_order_.insert({bb, post_order_.size()});
+    post_order_[bb] = post_order_vec_.size() - 1;
 }
 
 void Dominators::create_idom(Function *f) {
@@ -67,18 +71,14 @@ void Dominators::create_idom(Function *f) {
             auto bb = *it;
             if (bb == f->get_entry_block())
                 continue;
-            if (bb->get_pre_basic_blocks().empty())
-                continue;
-            BasicBlock *first_pred = bb->get_pre_basic_blocks().front();
-            BasicBlock *new_idom = first_pred;
+            // 以第一个已处理的前驱作为初值，跳过尚未处理或不可达的前驱
+            BasicBlock *new_idom = nullptr;
             for (auto &pred : bb->get_pre_basic_blocks()) {
-                if (pred == first_pred)
+                if (get_idom(pred) == nullptr)
                     continue;
-                if (get_idom(pred) != nullptr) {
-                    new_idom = intersect(pred, new_idom);
-                }
+                new_idom = new_idom ? intersect(pred, new_idom) : pred;
             }
-            if (new_idom != get_idom(bb)) {
+            if (new_idom != nullptr && new_idom != get_idom(bb)) {
                 changed = true;
                 idom_[bb] = new_idom;
             }
@@ -90,8 +90,10 @@ void Dominators::create_dominance_frontier(Function *f) {
     // 分析得到 f 中各个基本块的支配边界集合
     for (auto &bb1 : f->get_basic_blocks()) {
         auto bb = &bb1;
-        if (bb->get_pre_basic_blocks().size() >= 2) {
+        if (bb->get_pre_basic_blocks().size() >= 2 && get_idom(bb)) {
             for (auto &pred : bb->get_pre_basic_blocks()) {
+                if (get_idom(pred) == nullptr)
+                    continue;
                 auto runner = pred;
                 while (runner != get_idom(bb)) {
                     dom_frontier_[runner].insert(bb);
@@ -116,15 +118,16 @@ void Dominators::create_dom_tree_succ(Function *f) {
 void Dominators::create_dom_dfs_order(Function *f) {
     // 分析得到 f 中各个基本块的支配树上的dfs序L,R
     unsigned int order = 0;
-    std::function<void(BasicBlock *)> dfs = [&](BasicBlock *bb) {
+    std::function<void(BasicBlock *, int)> dfs = [&](BasicBlock *bb, int level) {
         dom_tree_L_[bb] = ++ order;
+        dom_tree_level_[bb] = level;
         dom_dfs_order_.push_back(bb);
         for (auto &succ : dom_tree_succ_blocks_[bb]) {
-            dfs(succ);
+            dfs(succ, level + 1);
         }
         dom_tree_R_[bb] = order;
     };
-    dfs(f->get_entry_block());
+    dfs(f->get_entry_block(), 0);
     dom_post_order_ =
         std::vector(dom_dfs_order_.rbegin(), dom_dfs_order_.rend());
 }
@@ -1,97 +1,125 @@
 #include "FuncInfo.hpp"
 #include "Function.hpp"
 
+#include <algorithm>
+
 void FuncInfo::run() {
+    summaries_.clear();
     for (auto &f : m_->get_functions()) {
-        auto func = &f;
-        trivial_mark(func);
-        if (not is_pure[func])
-            worklist.push_back(func);
-    }
-    while (worklist.empty() == false) {
-        auto now = worklist.front();
-        worklist.pop_front();
-        process(now);
+        auto &summary = summaries_[&f];
+        summary.arg_mod_ref.assign(f.get_num_of_args(), ModRefInfo::NoModRef);
+        if (f.is_declaration())
+            summary.has_io = summary.may_not_return = true;
     }
+    CallGraph call_graph(m_);
+    call_graph.run();
+    for (auto &scc : call_graph.get_sccs())
+        process(call_graph, scc);
     log();
 }
 
 void FuncInfo::log() {
-    for (auto it : is_pure) {
-        LOG_INFO << it.first->get_name() << " is pure? " << it.second;
+    for (auto &[func, summary] : summaries_) {
+        LOG_INFO << func->get_name() << " is readonly? " << is_readonly(func)
+                 << ", readnone? " << is_readnone(func);
     }
 }
 
-// 有 store 操作的函数非纯函数来处理
-void FuncInfo::trivial_mark(Function *func) {
-    if (func->is_declaration() or func->get_name() == "main") {
-        is_pure[func] = false;
-        return;
-    }
-    // 只要传入数组，都作为非纯函数处理
-    for (auto it = func->get_function_type()->param_begin();
-         it != func->get_function_type()->param_end(); ++it) {
-        auto arg_type = *it;
-        if (arg_type->is_integer_type() == false and
-            arg_type->is_float_type() == false) {
-            is_pure[func] = false;
-            return;
-        }
-    }
-    for (auto &bb : func->get_basic_blocks())
-        for (auto &inst : bb.get_instructions()) {
-            if (is_side_effect_inst(&inst)) {
-                is_pure[func] = false;
-                return;
-            }
+bool FuncInfo::is_readonly(Function *func) const {
+    auto &summary = summaries_.at(func);
+    return summary.mod_globals.empty() and not summary.has_io and
+           not summary.may_not_return and
+           std::none_of(summary.arg_mod_ref.begin(), summary.arg_mod_ref.end(),
+                        is_mod);
+}
+
+bool FuncInfo::is_readnone(Function *func) const {
+    auto &summary = summaries_.at(func);
+    return is_readonly(func) and summary.ref_globals.empty() and
+           std::none_of(summary.arg_mod_ref.begin(), summary.arg_mod_ref.end(),
+                        is_ref);
+}
+
+// 分量内的函数互相调用，摘要只会增大，迭代到不再变化为止
+void FuncInfo::process(CallGraph &call_graph, const CallGraph::SCC &scc) {
+    bool recursive = call_graph.is_recursive(scc.front());
+    bool changed;
+    do {
+        changed = false;
+        for (auto func : scc) {
+            if (not func->is_declaration())
+                changed |= update(func);
         }
-    is_pure[func] = true;
+    } while (changed and recursive);
 }
 
-void FuncInfo::process(Function *func) {
-    for (auto &use : func->get_use_list()) {
-        LOG_INFO << use.val_->print() << " uses func: " << func->get_name();
-        if (auto inst = dynamic_cast<Instruction *>(use.val_)) {
-            auto func = (inst->get_parent()->get_parent());
-            if (is_pure[func]) {
-                is_pure[func] = false;
-                worklist.push_back(func);
+// 根据函数体与被调函数当前的摘要重新计算 func 的摘要，返回是否变化
+bool FuncInfo::update(Function *func) {
+    FuncSummary summary;
+    summary.arg_mod_ref.assign(func->get_num_of_args(), ModRefInfo::NoModRef);
+    for (auto &bb : func->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            if (inst.is_load()) {
+                add_access(summary, func,
+                           static_cast<LoadInst *>(&inst)->get_lval(),
+                           ModRefInfo::Ref);
+            } else if (inst.is_store()) {
+                add_access(summary, func,
+                           static_cast<StoreInst *>(&inst)->get_lval(),
+                           ModRefInfo::Mod);
+            } else if (inst.is_call()) {
+                auto callee = static_cast<Function *>(inst.get_operand(0));
+                auto &callee_summary = summaries_.at(callee);
+                summary.ref_globals.insert(callee_summary.ref_globals.begin(),
+                                           callee_summary.ref_globals.end());
+                summary.mod_globals.insert(callee_summary.mod_globals.begin(),
+                                           callee_summary.mod_globals.end());
+                summary.has_io |= callee_summary.has_io;
+                summary.may_not_return |= callee_summary.may_not_return;
+                // 被调函数对形参的读写落在对应实参指向的内存上
+                for (unsigned i = 0; i < callee_summary.arg_mod_ref.size();
+                     i++) {
+                    if (callee_summary.arg_mod_ref[i] != ModRefInfo::NoModRef)
+                        add_access(summary, func, inst.get_operand(i + 1),
+                                   callee_summary.arg_mod_ref[i]);
+                }
             }
-        } else
-            LOG_WARNING << "Value besides instruction uses a function";
+        }
     }
+    auto &old = summaries_.at(func);
+    if (summary == old)
+        return false;
+    old = std::move(summary);
+    return true;
 }
 
-// 对局部变量进行 store 没有副作用
-bool FuncInfo::is_side_effect_inst(Instruction *inst) {
-    if (inst->is_store()) {
-        if (is_local_store(dynamic_cast<StoreInst *>(inst)))
-            return false;
-        return true;
+void FuncInfo::add_access(FuncSummary &summary, Function *func, Value *ptr,
+                          ModRefInfo info) {
+    auto addr = get_first_addr(ptr);
+    if (auto inst = dynamic_cast<Instruction *>(addr);
+        inst != nullptr and inst->is_alloca())
+        return;
+    if (auto global = dynamic_cast<GlobalVariable *>(addr)) {
+        if (is_ref(info))
+            summary.ref_globals.insert(global);
+        if (is_mod(info))
+            summary.mod_globals.insert(global);
+        return;
     }
-    if (inst->is_load()) {
-        if (is_local_load(dynamic_cast<LoadInst *>(inst)))
-            return false;
-        return true;
+    if (auto arg = dynamic_cast<Argument *>(addr)) {
+        auto &arg_info = summary.arg_mod_ref[arg->get_arg_no()];
+        arg_info = union_mod_ref(arg_info, info);
+        return;
+    }
+    // 基址无法确定（如从局部变量中读出的数组形参），视为访问所有指针形参
+    for (auto &arg : func->get_args()) {
+        if (arg.get_type()->is_pointer_type()) {
+            auto &arg_info = summary.arg_mod_ref[arg.get_arg_no()];
+            arg_info = union_mod_ref(arg_info, info);
+        }
     }
-    // call 指令的副作用会在后续 bfs 中计算
-    return false;
-}
-
-bool FuncInfo::is_local_load(LoadInst *inst) {
-    auto addr =
-        dynamic_cast<Instruction *>(get_first_addr(inst->get_operand(0)));
-    if (addr and addr->is_alloca())
-        return true;
-    return false;
 }
 
-bool FuncInfo::is_local_store(StoreInst *inst) {
-    auto addr = dynamic_cast<Instruction *>(get_first_addr(inst->get_lval()));
-    if (addr and addr->is_alloca())
-        return true;
-    return false;
-}
 Value *FuncInfo::get_first_addr(Value *val) {
     if (auto inst = dynamic_cast<Instruction *>(val)) {
         if (inst->is_alloca())
@@ -2,9 +2,12 @@
 #include "../../include/lightir/Function.hpp"
 
 #include "BasicBlock.hpp"
+#include "CallGraph.hpp"
+#include "Constant.hpp"
 #include "Instruction.hpp"
 #include "Value.hpp"
 #include "logging.hpp"
+#include <algorithm>
 #include <cassert>
 #include <utility>
 #include <vector>
@@ -12,53 +15,95 @@
 void FunctionInline::run() { inline_all_functions(); }
 
 void FunctionInline::inline_all_functions() {
-    // 检测递归函数
-    std::set<Function *> recursive_func;
-    for (auto &func : m_->get_functions()) {
-        for (auto &bb : func.get_basic_blocks()) {
-            for (auto &inst : bb.get_instructions()) {
-                if (inst.is_call()) {
-                    auto call = &inst;
-                    auto func1 = static_cast<Function *>(call->get_operand(0));
-                    if (func1 == &func) {
-                        recursive_func.insert(func1);
-                        break;
-                    }
-                }
-            }
+    CallGraph call_graph(m_);
+    call_graph.run();
+    LoopDetection loop_detection(m_);
+    // 按强连通分量自底向上内联，被调函数先完成内联后再被复制到调用者中
+    for (auto &scc : call_graph.get_sccs()) {
+        for (auto func : scc) {
+            // 跳过外部函数（如 output, input）
+            if (func->is_declaration())
+                continue;
+            inline_into(func, call_graph, loop_detection);
+            cost_[func] = compute_cost(func);
         }
     }
-    // 遍历所有函数进行内联
-    for (auto &func : m_->get_functions()) {
-        // 跳过外部函数（如 output, input）
-        if (outside_func.find(func.get_name()) != outside_func.end()) {
+}
+
+int FunctionInline::get_inst_cost(Instruction *inst) {
+    if (inst->is_phi() or inst->is_alloca() or inst->is_ret())
+        return 0;
+    if (inst->is_br())
+        return static_cast<BranchInst *>(inst)->is_cond_br() ? 1 : 0;
+    // 调用需要传递参数
+    if (inst->is_call())
+        return inst->get_num_operand();
+    return 1;
+}
+
+int FunctionInline::compute_cost(Function *func) {
+    int cost = 0;
+    for (auto &bb : func->get_basic_blocks())
+        for (auto &inst : bb.get_instructions())
+            cost += get_inst_cost(&inst);
+    return cost;
+}
+
+// 常量实参使被调函数中依赖它的计算与分支可以被折叠，
+// 循环中的调用执行次数多，节省的调用开销更可观
+int FunctionInline::get_threshold(const CallSite &site) {
+    int threshold = inline_threshold;
+    for (unsigned i = 1; i < site.call->get_num_operand(); i++) {
+        if (dynamic_cast<Constant *>(site.call->get_operand(i)) != nullptr)
+            threshold += const_arg_bonus;
+    }
+    if (site.in_loop)
+        threshold += loop_bonus;
+    return threshold;
+}
+
+void FunctionInline::inline_into(Function *caller, CallGraph &call_graph,
+                                 LoopDetection &loop_detection) {
+    loop_detection.run_on_func(caller);
+    int caller_cost = compute_cost(caller);
+    int cost_limit = caller_cost + std::max(min_growth_budget, caller_cost);
+
+    std::vector<CallSite> work_list;
+    for (auto call : call_graph.get_call_sites(caller))
+        work_list.push_back(
+            {call, loop_detection.get_loop_depth(call->get_parent()) > 0});
+    // 逆序放入，使调用点按程序顺序出栈
+    std::reverse(work_list.begin(), work_list.end());
+    while (not work_list.empty()) {
+        auto site = work_list.back();
+        work_list.pop_back();
+        auto callee = static_cast<Function *>(site.call->get_operand(0));
+        // 跳过外部函数与递归函数
+        if (callee->is_declaration() or callee == caller or
+            call_graph.is_recursive(callee))
             continue;
-        }
-    a1:
-        for (auto &bb : func.get_basic_blocks()) {
-            for (auto &inst : bb.get_instructions()) {
-                if (inst.is_call()) {
-                    auto call = &inst;
-                    auto func1 = static_cast<Function *>(call->get_operand(0));
-                    // 跳过递归、外部或过大函数
-                    if (func1 == &func)
-                        continue;
-                    if (recursive_func.find(func1) != recursive_func.end())
-                        continue;
-                    if (outside_func.find(func1->get_name()) !=
-                        outside_func.end())
-                        continue;
-                    if (func1->get_basic_blocks().size() >= 6)
-                        continue;
-                    inline_function(call, func1);
-                    goto a1; // 内联后重新扫描
-                }
-            }
-        }
+        auto cost_iter = cost_.find(callee);
+        int callee_cost = cost_iter != cost_.end() ? cost_iter->second
+                                                   : compute_cost(callee);
+        if (callee_cost > get_threshold(site))
+            continue;
+        int new_cost =
+            caller_cost + callee_cost - get_inst_cost(site.call);
+        if (new_cost > cost_limit)
+            continue;
+        LOG_INFO << "inline " << callee->get_name() << " into "
+                 << caller->get_name() << ", cost " << callee_cost;
+        caller_cost = new_cost;
+        auto new_calls = inline_function(site.call, callee);
+        for (auto iter = new_calls.rbegin(); iter != new_calls.rend(); ++iter)
+            work_list.push_back({*iter, site.in_loop});
     }
 }
 
-void FunctionInline::inline_function(Instruction *call, Function *origin) {
+std::vector<CallInst *> FunctionInline::inline_function(Instruction *call,
+                                                        Function *origin) {
+    // 复制进调用者的调用指令
+    std::vector<CallInst *> new_calls;
     // 值映射表：原函数的值 -> 新复制的值
     std::map<Value *, Value *> v_map;
     // 新基本块列表
@@ -102,6 +147,7 @@ void FunctionInline::inline_function(Instruction *call, Function *origin) {
                                         {call->get_operands().begin() + 1,
                                          call->get_operands().end()},
                                         bb_new);
+                new_calls.push_back(static_cast<CallInst *>(inst_new));
             } else {
                 // 其他指令通过 clone 复制（如 getelementptr, sub）
                 inst_new = inst.clone(bb_new);
@@ -206,16 +252,32 @@ void FunctionInline::inline_function(Instruction *call, Function *origin) {
             del_list.push_back(&inst);
         }
     }
-    // 移除调用指令
-    call_bb->remove_instr(call);
-    origin->remove_use(call, 0);
+    // 删除调用指令，同时从被调函数与实参的 use 链中移除
+    call_bb->erase_instr(call);
     // 移动后续指令到 bb_new
     for (auto inst : del_list) {
         call_bb->remove_instr(inst);
         bb_new->add_instruction(inst);
         inst->set_parent(bb_new);
     }
+    // 后继块中 phi 的来源由调用点基本块改为 bb_new
+    bb_new->redirect_succ_phis(call_bb);
+    // 局部数组移到调用者的入口块，避免在循环中内联后反复分配栈空间
+    auto entry = call_func->get_entry_block();
+    for (auto bb : bb_list) {
+        std::vector<Instruction *> allocas;
+        for (auto &inst : bb->get_instructions()) {
+            if (inst.is_alloca())
+                allocas.push_back(&inst);
+        }
+        for (auto inst : allocas) {
+            bb->remove_instr(inst);
+            entry->add_instr_begin(inst);
+            inst->set_parent(entry);
+        }
+    }
     // 重置控制流图
     origin->reset_bbs();
     call_func->reset_bbs();
+    return new_calls;
 }
\ No newline at end of file
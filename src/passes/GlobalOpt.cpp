@@ -0,0 +1,97 @@
+#include "GlobalOpt.hpp"
+#include "Constant.hpp"
+#include "GlobalVariable.hpp"
+#include "logging.hpp"
+
+void GlobalOpt::run() {
+    Function *main_func = nullptr;
+    for (auto &f : m_->get_functions()) {
+        if (f.get_name() == "main")
+            main_func = &f;
+    }
+
+    int const_count = 0, dead_store_count = 0, localize_count = 0;
+    for (auto &global : m_->get_global_variable()) {
+        Usage usage;
+        analyze(&global, usage);
+        if (usage.escaped)
+            continue;
+
+        if (usage.stores.empty()) {
+            // 从未写入：每次读取的都是初始值
+            bool all_folded = true;
+            for (auto load : usage.loads) {
+                auto init = get_init_value(&global, load->get_type());
+                if (init == nullptr) {
+                    all_folded = false;
+                    continue;
+                }
+                load->replace_all_use_with(init);
+                load->get_parent()->erase_instr(load);
+            }
+            const_count += all_folded;
+        } else if (usage.loads.empty()) {
+            // 从未读取：写入均无意义
+            for (auto store : usage.stores)
+                store->get_parent()->erase_instr(store);
+            dead_store_count++;
+        } else if (main_func != nullptr and main_func->get_use_list().empty() and
+                   usage.funcs.size() == 1 and *usage.funcs.begin() == main_func and
+                   get_init_value(&global, global.get_type()
+                                               ->get_pointer_element_type())) {
+            // main 只执行一次，只在 main 中使用的全局变量等价于 main 的局部变量
+            localize(&global, main_func);
+            localize_count++;
+        }
+    }
+    LOG_INFO << "global opt: " << const_count << " constant, "
+             << dead_store_count << " write-only, " << localize_count
+             << " localized";
+}
+
+void GlobalOpt::analyze(Value *ptr, Usage &usage) {
+    for (auto &use : ptr->get_use_list()) {
+        auto inst = dynamic_cast<Instruction *>(use.val_);
+        if (inst == nullptr) {
+            usage.escaped = true;
+            return;
+        }
+        usage.funcs.insert(inst->get_function());
+        if (inst->is_load())
+            usage.loads.push_back(static_cast<LoadInst *>(inst));
+        else if (inst->is_store() and use.arg_no_ == 1)
+            usage.stores.push_back(static_cast<StoreInst *>(inst));
+        else if (inst->is_gep() and use.arg_no_ == 0)
+            analyze(inst, usage);
+        else
+            usage.escaped = true; // 作为实参或被存入内存
+    }
+}
+
+Value *GlobalOpt::get_init_value(GlobalVariable *global, Type *ty) {
+    auto init = global->get_init();
+    if (dynamic_cast<ConstantZero *>(init) != nullptr) {
+        if (ty->is_integer_type())
+            return ConstantInt::get(0, m_);
+        if (ty->is_float_type())
+            return ConstantFP::get(0., m_);
+        return nullptr;
+    }
+    // 标量的初始值本身就是读取结果
+    if (init != nullptr and init->get_type() == ty)
+        return init;
+    return nullptr;
+}
+
+void GlobalOpt::localize(GlobalVariable *global, Function *main_func) {
+    auto entry = main_func->get_entry_block();
+    auto ty = global->get_type()->get_pointer_element_type();
+    auto alloca = AllocaInst::create_alloca(ty, entry);
+    auto store = StoreInst::create_store(get_init_value(global, ty), alloca, entry);
+    // 放到入口块开头：先 alloca，再写入初始值
+    entry->remove_instr(store);
+    entry->remove_instr(alloca);
+    entry->add_instr_begin(store);
+    entry->add_instr_begin(alloca);
+    global->replace_all_use_with(alloca);
+}
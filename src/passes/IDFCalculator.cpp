@@ -0,0 +1,52 @@
+#include "IDFCalculator.hpp"
+
+#include <queue>
+#include <tuple>
+
+void IDFCalculator::calculate(std::vector<BasicBlock *> &idf_blocks) {
+    idf_blocks.clear();
+    // 按 (深度, 支配树先序序号) 取最大者，保证先处理支配树中更深的根
+    using Node = std::tuple<int, unsigned int, BasicBlock *>;
+    std::priority_queue<Node> pq;
+    for (auto bb : *def_blocks_) {
+        auto level = dominators_->get_dom_tree_level(bb);
+        if (level >= 0)
+            pq.emplace(level, dominators_->get_dom_tree_dfs_in(bb), bb);
+    }
+
+    std::set<BasicBlock *> visited_pq;       // 已加入结果的块
+    std::set<BasicBlock *> visited_worklist; // 已遍历过的支配子树节点
+    std::vector<BasicBlock *> work_list;
+    while (not pq.empty()) {
+        auto [root_level, dfs_in, root] = pq.top();
+        pq.pop();
+        work_list.push_back(root);
+        visited_worklist.insert(root);
+        while (not work_list.empty()) {
+            auto bb = work_list.back();
+            work_list.pop_back();
+            for (auto succ : bb->get_succ_basic_blocks()) {
+                // 只沿 J 边：succ 的直接支配者不是 bb
+                if (dominators_->get_idom(succ) == bb)
+                    continue;
+                auto succ_level = dominators_->get_dom_tree_level(succ);
+                if (succ_level < 0 or succ_level > root_level)
+                    continue;
+                if (not visited_pq.insert(succ).second)
+                    continue;
+                if (live_in_blocks_ != nullptr and
+                    not live_in_blocks_->count(succ))
+                    continue;
+                idf_blocks.push_back(succ);
+                // phi 也是定值，succ 本身不是定值块时需继续计算它的边界
+                if (not def_blocks_->count(succ))
+                    pq.emplace(succ_level,
+                               dominators_->get_dom_tree_dfs_in(succ), succ);
+            }
+            for (auto child : dominators_->get_dom_tree_succ_blocks(bb)) {
+                if (visited_worklist.insert(child).second)
+                    work_list.push_back(child);
+            }
+        }
+    }
+}
@@ -0,0 +1,334 @@
+#include "IPSCCP.hpp"
+#include "BasicBlock.hpp"
+#include "CloneFunction.hpp"
+#include "Constant.hpp"
+#include "logging.hpp"
+
+void IPSCCP::run() {
+    solve();
+    // 特化产生的副本需要重新求解才能得到其中的常量
+    if (specialize())
+        solve();
+    rewrite();
+}
+
+IPSCCP::LatticeVal IPSCCP::meet(const LatticeVal &a, const LatticeVal &b) {
+    if (a.state == LatticeVal::Undef)
+        return b;
+    if (b.state == LatticeVal::Undef or a == b)
+        return a;
+    return {LatticeVal::Overdefined, nullptr};
+}
+
+IPSCCP::LatticeVal IPSCCP::get_value(Value *val) {
+    if (auto c = dynamic_cast<Constant *>(val))
+        return {LatticeVal::Const, c};
+    if (dynamic_cast<Instruction *>(val) != nullptr or
+        dynamic_cast<Argument *>(val) != nullptr) {
+        auto iter = values_.find(val);
+        return iter == values_.end() ? LatticeVal{} : iter->second;
+    }
+    return {LatticeVal::Overdefined, nullptr};
+}
+
+void IPSCCP::merge(Value *val, const LatticeVal &new_val) {
+    auto &old_val = values_[val];
+    auto merged = meet(old_val, new_val);
+    if (merged == old_val)
+        return;
+    old_val = merged;
+    for (auto &use : val->get_use_list()) {
+        auto user = dynamic_cast<Instruction *>(use.val_);
+        if (user != nullptr and executable_.count(user->get_parent()))
+            inst_work_list_.push_back(user);
+    }
+}
+
+void IPSCCP::merge_return(Function *func, const LatticeVal &new_val) {
+    auto &old_val = returns_[func];
+    auto merged = meet(old_val, new_val);
+    if (merged == old_val)
+        return;
+    old_val = merged;
+    for (auto &use : func->get_use_list()) {
+        auto call = dynamic_cast<CallInst *>(use.val_);
+        if (call != nullptr and executable_.count(call->get_parent()))
+            inst_work_list_.push_back(call);
+    }
+}
+
+void IPSCCP::mark_block(BasicBlock *bb) {
+    if (executable_.insert(bb).second)
+        block_work_list_.push_back(bb);
+}
+
+void IPSCCP::mark_edge(BasicBlock *from, BasicBlock *to) {
+    if (not executable_edges_.insert({from, to}).second)
+        return;
+    // 已可达的块多了一条可达入边，需要重新计算其中的 phi
+    if (executable_.count(to)) {
+        for (auto &inst : to->get_instructions()) {
+            if (not inst.is_phi())
+                break;
+            inst_work_list_.push_back(&inst);
+        }
+    }
+    mark_block(to);
+}
+
+void IPSCCP::solve() {
+    values_.clear();
+    returns_.clear();
+    executable_.clear();
+    executable_edges_.clear();
+    for (auto &f : m_->get_functions()) {
+        if (f.get_name() == "main" and not f.is_declaration())
+            mark_block(f.get_entry_block());
+    }
+    while (not block_work_list_.empty() or not inst_work_list_.empty()) {
+        while (not block_work_list_.empty()) {
+            auto bb = block_work_list_.back();
+            block_work_list_.pop_back();
+            for (auto &inst : bb->get_instructions())
+                visit(&inst);
+        }
+        while (not inst_work_list_.empty()) {
+            auto inst = inst_work_list_.back();
+            inst_work_list_.pop_back();
+            visit(inst);
+        }
+    }
+}
+
+void IPSCCP::visit(Instruction *inst) {
+    if (inst->is_phi()) {
+        visit_phi(static_cast<PhiInst *>(inst));
+    } else if (inst->is_br()) {
+        visit_branch(static_cast<BranchInst *>(inst));
+    } else if (inst->is_ret()) {
+        if (inst->get_num_operand() > 0)
+            merge_return(inst->get_function(), get_value(inst->get_operand(0)));
+    } else if (inst->is_call()) {
+        visit_call(static_cast<CallInst *>(inst));
+    } else if (inst->isBinary() or inst->is_cmp() or inst->is_fcmp() or
+               inst->is_zext() or inst->is_si2fp() or inst->is_fp2si()) {
+        visit_fold(inst);
+    } else if (not inst->is_void()) {
+        // load、alloca、gep 的结果不是常量
+        merge(inst, {LatticeVal::Overdefined, nullptr});
+    }
+}
+
+void IPSCCP::visit_phi(PhiInst *phi) {
+    LatticeVal result;
+    for (auto [val, pred] : phi->get_phi_pairs()) {
+        if (executable_edges_.count({pred, phi->get_parent()}))
+            result = meet(result, get_value(val));
+    }
+    merge(phi, result);
+}
+
+void IPSCCP::visit_branch(BranchInst *br) {
+    auto bb = br->get_parent();
+    if (not br->is_cond_br()) {
+        mark_edge(bb, br->get_operand(0)->as<BasicBlock>());
+        return;
+    }
+    auto cond = get_value(br->get_condition());
+    auto if_true = br->get_operand(1)->as<BasicBlock>();
+    auto if_false = br->get_operand(2)->as<BasicBlock>();
+    if (cond.state == LatticeVal::Undef)
+        return;
+    auto c = dynamic_cast<ConstantInt *>(cond.val);
+    if (cond.state == LatticeVal::Const and c != nullptr) {
+        mark_edge(bb, c->get_value() ? if_true : if_false);
+        return;
+    }
+    mark_edge(bb, if_true);
+    mark_edge(bb, if_false);
+}
+
+void IPSCCP::visit_call(CallInst *call) {
+    auto callee = static_cast<Function *>(call->get_operand(0));
+    if (callee->is_declaration()) {
+        if (not call->is_void())
+            merge(call, {LatticeVal::Overdefined, nullptr});
+        return;
+    }
+    mark_block(callee->get_entry_block());
+    for (auto &arg : callee->get_args())
+        merge(&arg, get_value(call->get_operand(arg.get_arg_no() + 1)));
+    if (not call->is_void())
+        merge(call, returns_[callee]);
+}
+
+void IPSCCP::visit_fold(Instruction *inst) {
+    std::vector<Constant *> operands;
+    for (auto op : inst->get_operands()) {
+        auto val = get_value(op);
+        if (val.state == LatticeVal::Overdefined) {
+            merge(inst, val);
+            return;
+        }
+        if (val.state == LatticeVal::Undef)
+            return;
+        operands.push_back(val.val);
+    }
+    auto op = inst->get_instr_type();
+    auto result = operands.size() == 1
+                      ? folder_.compute(op, operands[0])
+                      : folder_.compute(op, operands[0], operands[1]);
+    if (result == nullptr)
+        merge(inst, {LatticeVal::Overdefined, nullptr});
+    else
+        merge(inst, {LatticeVal::Const, result});
+}
+
+bool IPSCCP::specialize() {
+    LoopDetection loop_detection(m_);
+    loop_detection.run();
+
+    std::vector<Function *> funcs;
+    for (auto &f : m_->get_functions()) {
+        if (not f.is_declaration() and f.get_name() != "main" and
+            executable_.count(f.get_entry_block()))
+            funcs.push_back(&f);
+    }
+    unsigned clone_count = 0;
+    for (auto func : funcs) {
+        unsigned size = 0;
+        for (auto &bb : func->get_basic_blocks())
+            size += bb.get_instructions().size();
+        if (size > max_clone_size)
+            continue;
+
+        // 按传入的常量分组：形参编号 -> 常量
+        using Key = std::vector<std::pair<unsigned, Constant *>>;
+        std::map<Key, std::vector<CallInst *>> groups;
+        std::map<Key, bool> in_loop;
+        for (auto &use : func->get_use_list()) {
+            auto call = dynamic_cast<CallInst *>(use.val_);
+            if (call == nullptr or use.arg_no_ != 0 or
+                not executable_.count(call->get_parent()))
+                continue;
+            Key key;
+            for (auto &arg : func->get_args()) {
+                if (get_value(&arg).state != LatticeVal::Overdefined)
+                    continue;
+                auto actual = get_value(call->get_operand(arg.get_arg_no() + 1));
+                if (actual.state == LatticeVal::Const)
+                    key.push_back({arg.get_arg_no(), actual.val});
+            }
+            if (key.empty())
+                continue;
+            groups[key].push_back(call);
+            in_loop[key] = in_loop[key] or
+                           loop_detection.get_loop_depth(call->get_parent()) > 0;
+        }
+
+        // 调用点多的组优先
+        std::vector<std::pair<Key, std::vector<CallInst *>>> candidates;
+        for (auto &[key, calls] : groups) {
+            if (calls.size() >= 2 or in_loop[key])
+                candidates.push_back({key, calls});
+        }
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](auto &a, auto &b) {
+                             return a.second.size() > b.second.size();
+                         });
+        unsigned func_clones = 0;
+        for (auto &[key, calls] : candidates) {
+            if (clone_count >= max_clones or
+                func_clones >= max_clones_per_func)
+                break;
+            std::map<Value *, Value *> v_map;
+            auto clone = clone_function(
+                func, func->get_name() + "_spec" + std::to_string(func_clones),
+                v_map);
+            auto arg_iter = clone->get_args().begin();
+            for (auto [arg_no, c] : key) {
+                auto arg = std::next(arg_iter, arg_no);
+                arg->replace_all_use_with(c);
+            }
+            for (auto call : calls)
+                call->set_operand(0, clone);
+            LOG_INFO << "specialize " << func->get_name() << " for "
+                     << calls.size() << " call sites";
+            func_clones++;
+            clone_count++;
+        }
+    }
+    return clone_count > 0;
+}
+
+void IPSCCP::rewrite() {
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration() or not executable_.count(f.get_entry_block()))
+            continue;
+        for (auto &arg : f.get_args()) {
+            auto val = get_value(&arg);
+            if (val.state == LatticeVal::Const)
+                arg.replace_all_use_with(val.val);
+        }
+        for (auto &bb : f.get_basic_blocks()) {
+            if (not executable_.count(&bb))
+                continue;
+            for (auto &inst : bb.get_instructions()) {
+                if (inst.is_void())
+                    continue;
+                auto val = get_value(&inst);
+                if (val.state == LatticeVal::Const)
+                    inst.replace_all_use_with(val.val);
+            }
+            // 条件为常量的分支改为无条件跳转
+            auto br = dynamic_cast<BranchInst *>(bb.get_terminator());
+            if (br == nullptr or not br->is_cond_br())
+                continue;
+            auto cond = dynamic_cast<ConstantInt *>(br->get_condition());
+            if (cond == nullptr)
+                continue;
+            auto target = br->get_operand(cond->get_value() ? 1 : 2)
+                              ->as<BasicBlock>();
+            auto other = br->get_operand(cond->get_value() ? 2 : 1)
+                             ->as<BasicBlock>();
+            if (other != target) {
+                for (auto &inst : other->get_instructions()) {
+                    if (not inst.is_phi())
+                        break;
+                    static_cast<PhiInst *>(&inst)->remove_phi_operand(&bb);
+                }
+            }
+            bb.erase_instr(br);
+            BranchInst::create_br(target, &bb);
+        }
+        erase_dead_blocks(&f);
+    }
+}
+
+void IPSCCP::erase_dead_blocks(Function *func) {
+    // 不可执行的块可能构成环（如被跳过的循环），DeadCode 只删除没有前驱的块，
+    // 因此这里一次性删除所有不可执行的块
+    std::vector<BasicBlock *> dead_bbs;
+    for (auto &bb : func->get_basic_blocks()) {
+        if (not executable_.count(&bb))
+            dead_bbs.push_back(&bb);
+    }
+    for (auto bb : dead_bbs) {
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            for (auto &inst : succ->get_instructions()) {
+                if (not inst.is_phi())
+                    break;
+                static_cast<PhiInst *>(&inst)->remove_phi_operand(bb);
+            }
+        }
+    }
+    // 先删除跳转指令以维护前驱后继关系，再断开其余指令间的引用
+    for (auto bb : dead_bbs) {
+        if (bb->is_terminated())
+            bb->erase_instr(bb->get_terminator());
+        for (auto &inst : bb->get_instructions())
+            inst.remove_all_operands();
+    }
+    for (auto bb : dead_bbs)
+        bb->erase_from_parent();
+}
@@ -0,0 +1,407 @@
+#include "IndVarSimplify.hpp"
+#include "BasicBlock.hpp"
+#include "ConstFolder.hpp"
+#include "Constant.hpp"
+#include "logging.hpp"
+
+#include <climits>
+#include <tuple>
+
+// 递归识别仿射式的深度上限
+static constexpr unsigned MAX_DEPTH = 8;
+
+// 按 32 位补码回绕计算，与运行时语义一致
+static int wrap_add(int a, int b) {
+    return static_cast<int>(static_cast<unsigned>(a) + b);
+}
+
+static int wrap_mul(int a, int b) {
+    return static_cast<int>(static_cast<unsigned>(a) * b);
+}
+
+static Instruction *first_non_phi(BasicBlock *bb) {
+    for (auto &inst : bb->get_instructions()) {
+        if (not inst.is_phi())
+            return &inst;
+    }
+    return nullptr;
+}
+
+void IndVarSimplify::run() {
+    loop_detection_ = std::make_unique<LoopDetection>(m_);
+    loop_detection_->run();
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration())
+            continue;
+        // 内层循环先于外层循环处理
+        for (auto loop : loop_detection_->get_loops(&f))
+            run_on_loop(loop);
+    }
+}
+
+void IndVarSimplify::run_on_loop(Loop *loop) {
+    loop_ = loop;
+    preheader_ = loop->get_preheader();
+    latch_ = loop->get_single_latch();
+    if (preheader_ == nullptr or latch_ == nullptr)
+        return;
+    derived_.clear();
+    find_basic_ivs();
+    if (ivs_.empty())
+        return;
+    eliminate_redundant_ivs();
+    reduce_multiplies();
+    reduce_geps();
+    canonicalize_exit_conditions();
+}
+
+void IndVarSimplify::find_basic_ivs() {
+    ivs_.clear();
+    for (auto &inst : loop_->get_header()->get_instructions()) {
+        if (not inst.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&inst);
+        if (not phi->get_type()->is_int32_type() or
+            phi->get_num_operand() != 4)
+            continue;
+        Value *init = nullptr, *next = nullptr;
+        for (auto [val, bb] : phi->get_phi_pairs()) {
+            if (bb == preheader_)
+                init = val;
+            else if (bb == latch_)
+                next = val;
+        }
+        auto next_inst = dynamic_cast<IBinaryInst *>(next);
+        if (init == nullptr or next_inst == nullptr)
+            continue;
+        auto lhs = next_inst->get_operand(0);
+        auto rhs = next_inst->get_operand(1);
+        ConstantInt *step = nullptr;
+        if (next_inst->is_add() and lhs == phi)
+            step = dynamic_cast<ConstantInt *>(rhs);
+        else if (next_inst->is_add() and rhs == phi)
+            step = dynamic_cast<ConstantInt *>(lhs);
+        else if (next_inst->is_sub() and lhs == phi) {
+            if (auto c = dynamic_cast<ConstantInt *>(rhs))
+                step = ConstantInt::get(-c->get_value(), m_);
+        }
+        if (step == nullptr or step->get_value() == 0)
+            continue;
+        ivs_.push_back({phi, init, step});
+    }
+}
+
+const IndVarSimplify::InductionVar *IndVarSimplify::get_iv(Value *val) const {
+    for (auto &iv : ivs_) {
+        if (iv.phi == val)
+            return &iv;
+    }
+    return nullptr;
+}
+
+bool IndVarSimplify::get_affine(Value *val, Affine &affine, unsigned depth) {
+    if (depth > MAX_DEPTH)
+        return false;
+    if (auto phi = dynamic_cast<PhiInst *>(val)) {
+        if (auto iter = derived_.find(phi); iter != derived_.end()) {
+            affine = iter->second;
+            return true;
+        }
+        if (auto iv = get_iv(phi)) {
+            affine = {*iv, 1, nullptr, 0, 0};
+            return true;
+        }
+        return false;
+    }
+    auto inst = dynamic_cast<IBinaryInst *>(val);
+    if (inst == nullptr or loop_->is_invariant(inst))
+        return false;
+    auto lhs = inst->get_operand(0), rhs = inst->get_operand(1);
+    if (inst->is_add()) {
+        if (get_affine(lhs, affine, depth + 1) and
+            add_invariant(affine, rhs, 1))
+            return true;
+        return get_affine(rhs, affine, depth + 1) and
+               add_invariant(affine, lhs, 1);
+    }
+    if (inst->is_sub()) {
+        if (get_affine(lhs, affine, depth + 1))
+            return add_invariant(affine, rhs, -1);
+        if (not get_affine(rhs, affine, depth + 1))
+            return false;
+        // c - (i * s + v + o) = i * (-s) - v + (c - o)
+        affine.scale = wrap_mul(affine.scale, -1);
+        affine.var_coef = wrap_mul(affine.var_coef, -1);
+        affine.offset = wrap_mul(affine.offset, -1);
+        return add_invariant(affine, lhs, 1);
+    }
+    if (inst->is_mul()) {
+        auto c = dynamic_cast<ConstantInt *>(rhs);
+        auto other = lhs;
+        if (c == nullptr) {
+            c = dynamic_cast<ConstantInt *>(lhs);
+            other = rhs;
+        }
+        if (c == nullptr or not get_affine(other, affine, depth + 1))
+            return false;
+        affine.scale = wrap_mul(affine.scale, c->get_value());
+        affine.var_coef = wrap_mul(affine.var_coef, c->get_value());
+        affine.offset = wrap_mul(affine.offset, c->get_value());
+        return true;
+    }
+    return false;
+}
+
+bool IndVarSimplify::add_invariant(Affine &affine, Value *val, int sign) {
+    if (auto c = dynamic_cast<ConstantInt *>(val)) {
+        affine.offset = wrap_add(affine.offset, wrap_mul(c->get_value(), sign));
+        return true;
+    }
+    // 只记录一个非常数的循环不变量
+    if (not loop_->is_invariant(val) or
+        (affine.var != nullptr and affine.var != val))
+        return false;
+    affine.var = val;
+    affine.var_coef = wrap_add(affine.var_coef, sign);
+    return true;
+}
+
+Value *IndVarSimplify::emit_invariant(Value *var, int coef, int offset) {
+    Value *res = ConstantInt::get(offset, m_);
+    if (var != nullptr and coef != 0) {
+        builder_.set_insert_point(preheader_->get_terminator());
+        auto scaled = builder_.create_imul(var, ConstantInt::get(coef, m_));
+        res = builder_.create_iadd(scaled, res);
+    }
+    return res;
+}
+
+void IndVarSimplify::erase_dead(Instruction *inst,
+                                std::set<Instruction *> &erased) {
+    if (not inst->get_use_list().empty() or not inst->isBinary() or
+        not loop_->contains(inst->get_parent()))
+        return;
+    auto operands = inst->get_operands();
+    inst->get_parent()->erase_instr(inst);
+    erased.insert(inst);
+    for (auto op : operands) {
+        if (auto op_inst = dynamic_cast<Instruction *>(op))
+            erase_dead(op_inst, erased);
+    }
+}
+
+// 步长相同的基本归纳变量 j 可以表示为 i + (j_init - i_init)，从而删去 j 的 phi
+bool IndVarSimplify::eliminate_redundant_ivs() {
+    bool changed = false;
+    std::vector<InductionVar> kept;
+    for (auto &iv : ivs_) {
+        const InductionVar *canonical = nullptr;
+        for (auto &other : kept) {
+            if (static_cast<ConstantInt *>(other.step)->get_value() ==
+                static_cast<ConstantInt *>(iv.step)->get_value()) {
+                canonical = &other;
+                break;
+            }
+        }
+        if (canonical == nullptr) {
+            kept.push_back(iv);
+            continue;
+        }
+        builder_.set_insert_point(preheader_->get_terminator());
+        auto offset = builder_.create_isub(iv.init, canonical->init);
+        builder_.set_insert_point(first_non_phi(loop_->get_header()));
+        auto replace = builder_.create_iadd(canonical->phi, offset);
+        LOG_DEBUG << "merge induction variable " << iv.phi->get_name()
+                  << " into " << canonical->phi->get_name();
+        iv.phi->replace_all_use_with(replace);
+        loop_->get_header()->erase_instr(iv.phi);
+        changed = true;
+    }
+    ivs_ = kept;
+    return changed;
+}
+
+// 仿射式 i * s + v + c 中的乘法改写为 p + (v + c)，其中
+// p = phi [init * s, preheader], [p + step * s, latch]，相同 i 与 s 共用同一个 p。
+// s 也可以是常数与循环不变量 k 的乘积，即 (i * s + v + c) * k
+bool IndVarSimplify::reduce_multiplies() {
+    std::map<std::pair<PhiInst *, Value *>, PhiInst *> reduced;
+    std::vector<Instruction *> muls;
+    for (auto bb : loop_->get_blocks()) {
+        for (auto &inst : bb->get_instructions()) {
+            if (inst.is_mul())
+                muls.push_back(&inst);
+        }
+    }
+    auto pre_term = preheader_->get_terminator();
+    std::vector<InductionVar> derived;
+    std::set<Instruction *> erased;
+    // 从后往前处理，外层的乘法改写后，作为其操作数的乘法可能不再需要改写
+    for (auto iter = muls.rbegin(); iter != muls.rend(); iter++) {
+        auto mul = *iter;
+        if (erased.count(mul))
+            continue;
+        Affine affine;
+        Value *scale = nullptr, *factor = nullptr;
+        if (get_affine(mul, affine)) {
+            if (affine.scale == 0)
+                continue;
+            scale = ConstantInt::get(affine.scale, m_);
+        } else {
+            for (unsigned i = 0; i < 2 and scale == nullptr; i++) {
+                auto op = mul->get_operand(1 - i);
+                if (not loop_->is_invariant(op) or
+                    not get_affine(mul->get_operand(i), affine))
+                    continue;
+                factor = op;
+                builder_.set_insert_point(pre_term);
+                scale = builder_.create_imul(
+                    factor, ConstantInt::get(affine.scale, m_));
+            }
+            if (scale == nullptr)
+                continue;
+        }
+        auto &phi = reduced[{affine.iv.phi, scale}];
+        if (phi == nullptr) {
+            builder_.set_insert_point(pre_term);
+            auto init = builder_.create_imul(affine.iv.init, scale);
+            auto step = builder_.create_imul(affine.iv.step, scale);
+            auto header = loop_->get_header();
+            phi = PhiInst::create_phi(mul->get_type(), header);
+            header->add_instr_begin(phi);
+            phi->add_phi_pair_operand(init, preheader_);
+            builder_.set_insert_point(latch_->get_terminator());
+            auto next = builder_.create_iadd(phi, step);
+            phi->add_phi_pair_operand(next, latch_);
+            if (factor == nullptr)
+                derived_[phi] = {affine.iv, affine.scale, nullptr, 0, 0};
+            derived.push_back({phi, init, step});
+        }
+        auto offset =
+            emit_invariant(affine.var, affine.var_coef, affine.offset);
+        if (factor != nullptr) {
+            builder_.set_insert_point(pre_term);
+            offset = builder_.create_imul(offset, factor);
+        }
+        builder_.set_insert_point(mul);
+        mul->replace_all_use_with(builder_.create_iadd(phi, offset));
+        erase_dead(mul, erased);
+    }
+    ivs_.insert(ivs_.end(), derived.begin(), derived.end());
+    return not derived.empty();
+}
+
+// gep base, 0, i * s + v + c 改写为指针递推
+// p = phi [gep base, 0, init * s + v], [gep p, step * s]，再以 gep p, c 访问，
+// 只有常数偏移 c 不同的下标共用同一个 p
+bool IndVarSimplify::reduce_geps() {
+    using Key = std::tuple<Value *, PhiInst *, int, Value *, int>;
+    std::map<Key, PhiInst *> reduced;
+    std::vector<GetElementPtrInst *> geps;
+    for (auto bb : loop_->get_blocks()) {
+        for (auto &inst : bb->get_instructions()) {
+            if (inst.is_gep())
+                geps.push_back(static_cast<GetElementPtrInst *>(&inst));
+        }
+    }
+    bool changed = false;
+    for (auto gep : geps) {
+        auto base = gep->get_operand(0);
+        auto elem_ty = base->get_type()->get_pointer_element_type();
+        Value *index = nullptr;
+        if (elem_ty->is_array_type() and gep->get_num_operand() == 3) {
+            auto zero = dynamic_cast<ConstantInt *>(gep->get_operand(1));
+            if (zero == nullptr or zero->get_value() != 0)
+                continue;
+            index = gep->get_operand(2);
+        } else if (not elem_ty->is_array_type() and
+                   gep->get_num_operand() == 2) {
+            index = gep->get_operand(1);
+        } else {
+            continue;
+        }
+        Affine affine;
+        if (not get_affine(index, affine) or affine.scale == 0 or
+            not loop_->is_invariant(base))
+            continue;
+        if (affine.var_coef == 0)
+            affine.var = nullptr;
+        auto &phi = reduced[{base, affine.iv.phi, affine.scale, affine.var,
+                             affine.var_coef}];
+        if (phi == nullptr) {
+            auto scale = ConstantInt::get(affine.scale, m_);
+            auto var = emit_invariant(affine.var, affine.var_coef, 0);
+            builder_.set_insert_point(preheader_->get_terminator());
+            auto init_idx = builder_.create_iadd(
+                builder_.create_imul(affine.iv.init, scale), var);
+            auto step = builder_.create_imul(affine.iv.step, scale);
+            std::vector<Value *> init_idxs;
+            if (elem_ty->is_array_type())
+                init_idxs.push_back(ConstantInt::get(0, m_));
+            init_idxs.push_back(init_idx);
+            auto init = builder_.create_gep(base, init_idxs);
+            auto header = loop_->get_header();
+            phi = PhiInst::create_phi(gep->get_type(), header);
+            header->add_instr_begin(phi);
+            phi->add_phi_pair_operand(init, preheader_);
+            builder_.set_insert_point(latch_->get_terminator());
+            auto next = builder_.create_gep(phi, {step});
+            phi->add_phi_pair_operand(next, latch_);
+        }
+        Value *replace = phi;
+        if (affine.offset != 0) {
+            builder_.set_insert_point(gep);
+            replace =
+                builder_.create_gep(phi, {ConstantInt::get(affine.offset, m_)});
+        }
+        gep->replace_all_use_with(replace);
+        gep->get_parent()->erase_instr(gep);
+        changed = true;
+    }
+    return changed;
+}
+
+// 退出条件规范化为 icmp slt/sgt/eq/ne iv, bound
+bool IndVarSimplify::canonicalize_exit_conditions() {
+    bool changed = false;
+    for (auto bb : loop_->get_exiting_blocks()) {
+        auto br = dynamic_cast<BranchInst *>(bb->get_terminator());
+        if (br == nullptr or not br->is_cond_br())
+            continue;
+        auto cond = dynamic_cast<ICmpInst *>(br->get_condition());
+        // 兼容 icmp ne (zext cmp), 0 的形式
+        if (cond and cond->get_instr_type() == Instruction::ne) {
+            auto zero = dynamic_cast<ConstantInt *>(cond->get_operand(1));
+            auto zext = dynamic_cast<ZextInst *>(cond->get_operand(0));
+            if (zero and zero->get_value() == 0 and zext)
+                cond = dynamic_cast<ICmpInst *>(zext->get_operand(0));
+        }
+        if (cond == nullptr)
+            continue;
+        auto lhs = cond->get_operand(0), rhs = cond->get_operand(1);
+        Affine affine;
+        if (loop_->is_invariant(lhs) and get_affine(rhs, affine)) {
+            cond->set_operand(0, rhs);
+            cond->set_operand(1, lhs);
+            cond->op_id_ =
+                ConstFolder::swap_predicate(cond->get_instr_type());
+            std::swap(lhs, rhs);
+            changed = true;
+        }
+        auto bound = dynamic_cast<ConstantInt *>(rhs);
+        if (bound == nullptr or not get_affine(lhs, affine))
+            continue;
+        if (cond->get_instr_type() == Instruction::le and
+            bound->get_value() != INT_MAX) {
+            cond->set_operand(1, ConstantInt::get(bound->get_value() + 1, m_));
+            cond->op_id_ = Instruction::lt;
+            changed = true;
+        } else if (cond->get_instr_type() == Instruction::ge and
+                   bound->get_value() != INT_MIN) {
+            cond->set_operand(1, ConstantInt::get(bound->get_value() - 1, m_));
+            cond->op_id_ = Instruction::gt;
+            changed = true;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,251 @@
+#include "InstCombine.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "PatternMatch.hpp"
+#include "logging.hpp"
+
+#include <climits>
+
+using namespace PatternMatch;
+
+// 比较的折叠结果为 i1 常量
+static bool is_true(Constant *c) {
+    return static_cast<ConstantInt *>(c)->get_value() != 0;
+}
+
+static bool is_commutative(Instruction::OpID op) {
+    return op == Instruction::add or op == Instruction::mul or
+           op == Instruction::fadd or op == Instruction::fmul;
+}
+
+void InstCombine::run() {
+    for (auto &f : m_->get_functions()) {
+        for (auto &bb : f.get_basic_blocks()) {
+            for (auto &inst : bb.get_instructions())
+                push(&inst);
+        }
+        while (not work_list_.empty()) {
+            auto inst = work_list_.front();
+            work_list_.pop_front();
+            if (in_work_list_.erase(inst) == 0)
+                continue; // 已被删除
+            auto res = simplify(inst);
+            if (res == nullptr)
+                continue;
+            combine_count_++;
+            if (res == inst) {
+                push(inst);
+                push_users(inst);
+                continue;
+            }
+            push_users(inst);
+            push(res);
+            inst->replace_all_use_with(res);
+            erase(inst);
+        }
+    }
+    LOG_INFO << "inst combine simplified " << combine_count_
+             << " instructions";
+}
+
+void InstCombine::push(Value *val) {
+    auto inst = dynamic_cast<Instruction *>(val);
+    if (inst != nullptr and in_work_list_.insert(inst).second)
+        work_list_.push_back(inst);
+}
+
+void InstCombine::push_users(Value *val) {
+    for (auto &use : val->get_use_list())
+        push(use.val_);
+}
+
+void InstCombine::erase(Instruction *inst) {
+    for (auto op : inst->get_operands())
+        push(op);
+    in_work_list_.erase(inst);
+    inst->get_parent()->erase_instr(inst);
+}
+
+Value *InstCombine::simplify(Instruction *inst) {
+    switch (inst->get_instr_type()) {
+    case Instruction::add:
+    case Instruction::sub:
+    case Instruction::mul:
+    case Instruction::sdiv:
+        return simplify_int_binary(inst);
+    case Instruction::fadd:
+    case Instruction::fsub:
+    case Instruction::fmul:
+    case Instruction::fdiv:
+        return simplify_float_binary(inst);
+    case Instruction::zext:
+    case Instruction::sitofp:
+    case Instruction::fptosi:
+        return simplify_cast(inst);
+    default:
+        break;
+    }
+    if (inst->is_cmp())
+        return simplify_icmp(inst);
+    if (inst->is_fcmp())
+        return simplify_fcmp(inst);
+    return nullptr;
+}
+
+Value *InstCombine::simplify_int_binary(Instruction *inst) {
+    auto op = inst->get_instr_type();
+    auto lhs = inst->get_operand(0), rhs = inst->get_operand(1);
+    Value *x, *y;
+    ConstantInt *c1, *c2;
+
+    // 常量折叠与 x+0、x-0、x*1、x*0、x/1、x-x 等恒等式
+    if (auto res = folder_.simplify(op, lhs, rhs))
+        return res;
+    // 交换律运算的常量放到右侧
+    if (is_commutative(op) and match(lhs, m_Constant()) and
+        not match(rhs, m_Constant())) {
+        inst->set_operand(0, rhs);
+        inst->set_operand(1, lhs);
+        return inst;
+    }
+
+    // 0 - (0 - x) => x
+    if (match(inst, m_Sub(m_ConstInt(0), m_Sub(m_ConstInt(0), m_Value(x)))))
+        return x;
+    // x - (0 - y) => x + y
+    if (match(inst, m_Sub(m_Value(x), m_Sub(m_ConstInt(0), m_Value(y))))) {
+        inst->op_id_ = Instruction::add;
+        inst->set_operand(1, y);
+        return inst;
+    }
+    // x + (0 - y), (0 - y) + x => x - y
+    if (match(inst, m_c_Add(m_Value(x), m_Sub(m_ConstInt(0), m_Value(y))))) {
+        inst->op_id_ = Instruction::sub;
+        inst->set_operand(0, x);
+        inst->set_operand(1, y);
+        return inst;
+    }
+    // x - c => x + (-c)，便于与其它加法合并
+    if (match(inst, m_Sub(m_Value(x), m_ConstInt(c1))) and
+        c1->get_value() != INT_MIN) {
+        inst->op_id_ = Instruction::add;
+        inst->set_operand(1, ConstantInt::get(-c1->get_value(), m_));
+        return inst;
+    }
+    // (x + c1) + c2 => x + (c1 + c2)，(x * c1) * c2 => x * (c1 * c2)
+    if (match(inst, m_Add(m_Add(m_Value(x), m_ConstInt(c1)), m_ConstInt(c2)))) {
+        inst->set_operand(0, x);
+        inst->set_operand(1, folder_.compute(Instruction::add, c1, c2));
+        return inst;
+    }
+    if (match(inst, m_Mul(m_Mul(m_Value(x), m_ConstInt(c1)), m_ConstInt(c2)))) {
+        inst->set_operand(0, x);
+        inst->set_operand(1, folder_.compute(Instruction::mul, c1, c2));
+        return inst;
+    }
+    return nullptr;
+}
+
+Value *InstCombine::simplify_float_binary(Instruction *inst) {
+    auto op = inst->get_instr_type();
+    auto lhs = inst->get_operand(0), rhs = inst->get_operand(1);
+    Value *x;
+
+    // 常量折叠与 x*1.0、x/1.0、x-0.0 等恒等式
+    if (auto res = folder_.simplify(op, lhs, rhs))
+        return res;
+    if (is_commutative(op) and match(lhs, m_Constant()) and
+        not match(rhs, m_Constant())) {
+        inst->set_operand(0, rhs);
+        inst->set_operand(1, lhs);
+        return inst;
+    }
+    // x + (-0.0) => x，对所有输入（含 -0.0、NaN、无穷）都成立
+    if (match(inst, m_FAdd(m_Value(x), m_ConstFP(-0.0f))))
+        return x;
+    return nullptr;
+}
+
+Value *InstCombine::simplify_icmp(Instruction *inst) {
+    auto op = inst->get_instr_type();
+    auto lhs = inst->get_operand(0), rhs = inst->get_operand(1);
+    Instruction::OpID pred;
+    Value *x;
+    ConstantInt *c2;
+
+    // 常量折叠，以及 x op x
+    if (auto res = folder_.simplify(op, lhs, rhs))
+        return res;
+    if (match(lhs, m_Constant()) and not match(rhs, m_Constant())) {
+        inst->set_operand(0, rhs);
+        inst->set_operand(1, lhs);
+        inst->op_id_ = ConstFolder::swap_predicate(op);
+        return inst;
+    }
+
+    // (zext c) op k：zext 只能取 0 或 1，比较结果为常量、c 或 c 取反
+    if (match(inst, m_ICmp(pred, m_ZExt(m_Value(x)), m_ConstInt(c2)))) {
+        bool if_false =
+            is_true(folder_.compute(op, ConstantInt::get(0, m_), c2));
+        bool if_true =
+            is_true(folder_.compute(op, ConstantInt::get(1, m_), c2));
+        if (if_false == if_true)
+            return ConstantInt::get(if_true, m_);
+        if (if_true)
+            return x;
+        // 取反：将 inst 改写为谓词相反的原比较
+        Value *a, *b;
+        if (match(x, m_ICmp(pred, m_Value(a), m_Value(b)))) {
+            inst->op_id_ = ConstFolder::invert_predicate(pred);
+            inst->set_operand(0, a);
+            inst->set_operand(1, b);
+            return inst;
+        }
+    }
+    return nullptr;
+}
+
+Value *InstCombine::simplify_fcmp(Instruction *inst) {
+    auto op = inst->get_instr_type();
+    auto lhs = inst->get_operand(0), rhs = inst->get_operand(1);
+    Instruction::OpID pred;
+    Value *x;
+    ConstantFP *c2;
+
+    if (auto res = folder_.simplify(op, lhs, rhs))
+        return res;
+    if (match(lhs, m_Constant()) and not match(rhs, m_Constant())) {
+        inst->set_operand(0, rhs);
+        inst->set_operand(1, lhs);
+        inst->op_id_ = ConstFolder::swap_predicate(op);
+        return inst;
+    }
+    // (sitofp (zext c)) op k
+    if (match(inst, m_FCmp(pred, m_SIToFP(m_ZExt(m_Value(x))),
+                           m_ConstFP(c2)))) {
+        bool if_false =
+            is_true(folder_.compute(op, ConstantFP::get(0.0f, m_), c2));
+        bool if_true =
+            is_true(folder_.compute(op, ConstantFP::get(1.0f, m_), c2));
+        if (if_false == if_true)
+            return ConstantInt::get(if_true, m_);
+        if (if_true)
+            return x;
+    }
+    return nullptr;
+}
+
+Value *InstCombine::simplify_cast(Instruction *inst) {
+    Value *x;
+    // 常量折叠，超出 i32 范围（含 NaN）的 fptosi 结果未定义，不折叠
+    if (auto res = folder_.simplify(inst->get_instr_type(),
+                                    inst->get_operand(0)))
+        return res;
+    // float 只有 24 位尾数，只有 |x| <= 2^24 时 fptosi(sitofp(x)) == x，
+    // 这里只处理取值为 0 或 1 的 zext
+    if (match(inst, m_FPToSI(m_SIToFP(m_Value(x)))) and
+        match(x, m_ZExt(m_Value())))
+        return x;
+    return nullptr;
+}
@@ -0,0 +1,143 @@
+#include "LoadStoreElim.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+void LoadStoreElim::run() {
+    alias_analysis_ = std::make_unique<AliasAnalysis>(m_);
+    alias_analysis_->run();
+    dominators_ = std::make_unique<Dominators>(m_);
+    dominators_->run();
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration())
+            continue;
+        forward_loads(&f);
+        for (auto &bb : f.get_basic_blocks())
+            eliminate_dead_stores(&bb);
+        eliminate_unread_stores(&f);
+    }
+    LOG_INFO << "load store elim: removed " << load_count_ << " loads, "
+             << store_count_ << " stores";
+}
+
+void LoadStoreElim::forward_loads(Function *func) {
+    MemorySSA memory_ssa(func, alias_analysis_.get(), dominators_.get());
+    // 按最近写入者分组的、已处理过的 load
+    std::map<MemoryAccess *, std::vector<LoadInst *>> loads;
+    // 支配树先序遍历，保证可以复用的 load 先于当前 load 被处理
+    std::vector<BasicBlock *> work_list{func->get_entry_block()};
+    while (not work_list.empty()) {
+        auto bb = work_list.back();
+        work_list.pop_back();
+        std::vector<Instruction *> wait_delete;
+        for (auto &inst : bb->get_instructions()) {
+            if (not inst.is_load())
+                continue;
+            auto load = static_cast<LoadInst *>(&inst);
+            auto ptr = load->get_lval();
+            auto clobber = memory_ssa.get_clobbering_access(load);
+            Value *found = nullptr;
+            // 最近写入者是对同一地址的 store：直接使用存入的值
+            if (clobber->is_def() and
+                not memory_ssa.is_live_on_entry(clobber)) {
+                auto def = static_cast<MemoryDef *>(clobber)->get_instruction();
+                auto store = dynamic_cast<StoreInst *>(def);
+                if (store != nullptr and
+                    alias_analysis_->alias(store->get_lval(), ptr) ==
+                        AliasResult::MustAlias and
+                    store->get_rval()->get_type() == load->get_type())
+                    found = store->get_rval();
+            }
+            // 最近写入者相同、支配当前 load 的同地址 load
+            auto &candidates = loads[clobber];
+            for (auto iter = candidates.begin();
+                 found == nullptr and iter != candidates.end(); ++iter) {
+                if (dominators_->is_dominate((*iter)->get_parent(), bb) and
+                    alias_analysis_->alias((*iter)->get_lval(), ptr) ==
+                        AliasResult::MustAlias and
+                    (*iter)->get_type() == load->get_type())
+                    found = *iter;
+            }
+            if (found != nullptr) {
+                load->replace_all_use_with(found);
+                memory_ssa.remove_access(load);
+                wait_delete.push_back(load);
+            } else {
+                candidates.push_back(load);
+            }
+        }
+        for (auto inst : wait_delete)
+            bb->erase_instr(inst);
+        load_count_ += wait_delete.size();
+
+        for (auto child : dominators_->get_dom_tree_succ_blocks(bb))
+            work_list.push_back(child);
+    }
+}
+
+// 同一地址的 store 之间若没有可能读取它的指令，前一个 store 是死的
+void LoadStoreElim::eliminate_dead_stores(BasicBlock *bb) {
+    std::vector<StoreInst *> pending;
+    std::vector<Instruction *> wait_delete;
+    for (auto &inst : bb->get_instructions()) {
+        if (inst.is_store()) {
+            auto store = static_cast<StoreInst *>(&inst);
+            for (auto iter = pending.begin(); iter != pending.end();) {
+                if (alias_analysis_->alias((*iter)->get_lval(),
+                                           store->get_lval()) ==
+                    AliasResult::MustAlias) {
+                    wait_delete.push_back(*iter);
+                    iter = pending.erase(iter);
+                } else {
+                    ++iter;
+                }
+            }
+            pending.push_back(store);
+        } else if (inst.is_load() or inst.is_call()) {
+            // 可能读取 pending 中地址的指令使其不再是死 store
+            for (auto iter = pending.begin(); iter != pending.end();) {
+                if (is_ref(alias_analysis_->get_mod_ref_info(
+                        &inst, (*iter)->get_lval())))
+                    iter = pending.erase(iter);
+                else
+                    ++iter;
+            }
+        }
+    }
+    for (auto inst : wait_delete)
+        bb->erase_instr(inst);
+    store_count_ += wait_delete.size();
+}
+
+// 局部 alloca 只被写入、从未被读取或传出时，全部写入都是死的
+void LoadStoreElim::eliminate_unread_stores(Function *func) {
+    std::vector<AllocaInst *> allocas;
+    for (auto &bb : func->get_basic_blocks()) {
+        for (auto &inst : bb.get_instructions()) {
+            if (auto alloca = dynamic_cast<AllocaInst *>(&inst))
+                allocas.push_back(alloca);
+        }
+    }
+    for (auto alloca : allocas) {
+        std::vector<StoreInst *> stores;
+        bool read = false;
+        std::vector<Value *> ptrs{alloca};
+        while (not ptrs.empty() and not read) {
+            auto ptr = ptrs.back();
+            ptrs.pop_back();
+            for (auto &use : ptr->get_use_list()) {
+                auto inst = dynamic_cast<Instruction *>(use.val_);
+                if (inst != nullptr and inst->is_store() and use.arg_no_ == 1)
+                    stores.push_back(static_cast<StoreInst *>(inst));
+                else if (inst != nullptr and inst->is_gep() and use.arg_no_ == 0)
+                    ptrs.push_back(inst);
+                else
+                    read = true;
+            }
+        }
+        if (read)
+            continue;
+        for (auto store : stores)
+            store->get_parent()->erase_instr(store);
+        store_count_ += stores.size();
+    }
+}
@@ -0,0 +1,147 @@
+#include "LoopDetection.hpp"
+#include "Instruction.hpp"
+
+#include <algorithm>
+
+bool Loop::contains(Loop *loop) const {
+    for (; loop != nullptr; loop = loop->get_parent()) {
+        if (loop == this)
+            return true;
+    }
+    return false;
+}
+
+BasicBlock *Loop::get_preheader() const {
+    BasicBlock *preheader = nullptr;
+    for (auto pred : header_->get_pre_basic_blocks()) {
+        if (contains(pred))
+            continue;
+        if (preheader != nullptr && preheader != pred)
+            return nullptr;
+        preheader = pred;
+    }
+    if (preheader == nullptr || preheader->get_succ_basic_blocks().size() != 1)
+        return nullptr;
+    return preheader;
+}
+
+std::vector<BasicBlock *> Loop::get_exit_blocks() const {
+    std::vector<BasicBlock *> exits;
+    for (auto bb : blocks_) {
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            if (not contains(succ) and
+                std::find(exits.begin(), exits.end(), succ) == exits.end())
+                exits.push_back(succ);
+        }
+    }
+    return exits;
+}
+
+std::vector<BasicBlock *> Loop::get_exiting_blocks() const {
+    std::vector<BasicBlock *> exiting;
+    for (auto bb : blocks_) {
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            if (not contains(succ)) {
+                exiting.push_back(bb);
+                break;
+            }
+        }
+    }
+    return exiting;
+}
+
+bool Loop::is_invariant(Value *val) const {
+    if (auto inst = dynamic_cast<Instruction *>(val))
+        return not contains(inst->get_parent());
+    return true;
+}
+
+void LoopDetection::run() {
+    dominators_ = std::make_unique<Dominators>(m_);
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration())
+            continue;
+        run_on_func(&f);
+    }
+}
+
+void LoopDetection::run_on_func(Function *f) {
+    if (dominators_ == nullptr)
+        dominators_ = std::make_unique<Dominators>(m_);
+    dominators_->run_on_func(f);
+    loops_[f].clear();
+    for (auto &bb : f->get_basic_blocks())
+        bb_to_loop_.erase(&bb);
+
+    // 步骤一：寻找回边 latch->header（header 支配 latch），按 header 归并
+    std::map<BasicBlock *, Loop *> header_to_loop;
+    std::vector<Loop *> loops;
+    for (auto &bb1 : f->get_basic_blocks()) {
+        auto bb = &bb1;
+        if (dominators_->get_idom(bb) == nullptr)
+            continue; // 不可达的基本块
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            if (dominators_->get_idom(succ) == nullptr or
+                not dominators_->is_dominate(succ, bb))
+                continue;
+            auto &loop = header_to_loop[succ];
+            if (loop == nullptr) {
+                loop_pool_.push_back(std::make_unique<Loop>(succ));
+                loop = loop_pool_.back().get();
+                loops.push_back(loop);
+            }
+            if (std::find(loop->latches_.begin(), loop->latches_.end(), bb) ==
+                loop->latches_.end()) {
+                loop->latches_.push_back(bb);
+                // 步骤二：从 latch 反向搜索，直到 header 为止
+                discover_loop(loop, bb);
+            }
+        }
+    }
+
+    // 步骤三：按规模从小到大排序，内层循环一定先于外层循环
+    std::stable_sort(loops.begin(), loops.end(), [](Loop *a, Loop *b) {
+        return a->get_blocks().size() < b->get_blocks().size();
+    });
+    for (unsigned i = 0; i < loops.size(); i++) {
+        for (unsigned j = i + 1; j < loops.size(); j++) {
+            if (loops[j]->contains(loops[i]->get_header())) {
+                loops[i]->parent_ = loops[j];
+                loops[j]->sub_loops_.push_back(loops[i]);
+                break;
+            }
+        }
+        for (auto bb : loops[i]->get_blocks())
+            bb_to_loop_.insert({bb, loops[i]});
+    }
+    loops_[f] = loops;
+}
+
+void LoopDetection::discover_loop(Loop *loop, BasicBlock *latch) {
+    std::vector<BasicBlock *> work_list{latch};
+    while (not work_list.empty()) {
+        auto bb = work_list.back();
+        work_list.pop_back();
+        if (not loop->blocks_.insert(bb).second)
+            continue;
+        for (auto pred : bb->get_pre_basic_blocks()) {
+            if (dominators_->get_idom(pred) != nullptr and
+                not loop->contains(pred))
+                work_list.push_back(pred);
+        }
+    }
+}
+
+void LoopDetection::print() {
+    m_->set_print_name();
+    for (auto &[func, loops] : loops_) {
+        printf("Loops of function %s:\n", func->get_name().c_str());
+        for (auto loop : loops) {
+            std::string output = loop->get_header()->get_name() + " (depth " +
+                                 std::to_string(loop->get_depth()) + "):";
+            for (auto bb : loop->get_blocks())
+                output += " " + bb->get_name();
+            printf("%s\n", output.c_str());
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#include "LoopPromotion.hpp"
+#include "GlobalVariable.hpp"
+#include "Mem2Reg.hpp"
+#include "logging.hpp"
+
+#include <map>
+
+void LoopPromotion::run() {
+    func_info_ = std::make_unique<FuncInfo>(m_);
+    func_info_->run();
+    LoopDetection loop_detection(m_);
+    loop_detection.run();
+
+    unsigned count = 0;
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration())
+            continue;
+        // 内层循环在前：外层循环随后会把内层 preheader 与退出块中的访问继续外提
+        for (auto loop : loop_detection.get_loops(&f))
+            count += run_on_loop(loop);
+    }
+    LOG_INFO << "loop promotion: promoted " << count << " loops";
+    if (count > 0)
+        Mem2Reg(m_).run();
+}
+
+// 循环中是否调用了可能访问全局变量的函数；外部运行时函数不访问程序的全局变量
+bool LoopPromotion::has_unknown_call(Loop *loop) {
+    for (auto bb : loop->get_blocks()) {
+        for (auto &inst : bb->get_instructions()) {
+            if (not inst.is_call())
+                continue;
+            auto callee = static_cast<Function *>(inst.get_operand(0));
+            if (not callee->is_declaration() and
+                not func_info_->is_readnone(callee))
+                return true;
+        }
+    }
+    return false;
+}
+
+bool LoopPromotion::run_on_loop(Loop *loop) {
+    auto preheader = loop->get_preheader();
+    if (preheader == nullptr or has_unknown_call(loop))
+        return false;
+    for (auto exit_bb : loop->get_exit_blocks()) {
+        for (auto pred : exit_bb->get_pre_basic_blocks()) {
+            if (not loop->contains(pred))
+                return false;
+        }
+    }
+
+    // 收集循环内直接以全局标量为地址的 load/store
+    std::map<GlobalVariable *, std::vector<Instruction *>> accesses;
+    std::map<GlobalVariable *, bool> has_store;
+    for (auto bb : loop->get_blocks()) {
+        for (auto &inst : bb->get_instructions()) {
+            Value *ptr = nullptr;
+            if (inst.is_load())
+                ptr = static_cast<LoadInst *>(&inst)->get_lval();
+            else if (inst.is_store())
+                ptr = static_cast<StoreInst *>(&inst)->get_lval();
+            auto global = dynamic_cast<GlobalVariable *>(ptr);
+            if (global == nullptr)
+                continue;
+            accesses[global].push_back(&inst);
+            has_store[global] |= inst.is_store();
+        }
+    }
+    for (auto &[global, insts] : accesses)
+        promote(loop, global, insts, has_store[global]);
+    return not accesses.empty();
+}
+
+void LoopPromotion::promote(Loop *loop, GlobalVariable *global,
+                            const std::vector<Instruction *> &accesses,
+                            bool has_store) {
+    auto ty = global->get_type()->get_pointer_element_type();
+    auto func = loop->get_header()->get_parent();
+    auto entry = func->get_entry_block();
+    auto alloca = AllocaInst::create_alloca(ty, entry);
+    entry->remove_instr(alloca);
+    entry->add_instr_begin(alloca);
+
+    // preheader 中读取初值
+    auto preheader = loop->get_preheader();
+    auto term = preheader->get_terminator();
+    auto init = LoadInst::create_load(global, preheader);
+    preheader->remove_instr(init);
+    preheader->insert_before(term, init);
+    auto store = StoreInst::create_store(init, alloca, preheader);
+    preheader->remove_instr(store);
+    preheader->insert_before(term, store);
+
+    for (auto inst : accesses) {
+        auto ptr_no = inst->is_load() ? 0 : 1;
+        inst->set_operand(ptr_no, alloca);
+    }
+    if (not has_store)
+        return;
+
+    // 退出块开头（phi 之后）写回
+    for (auto exit_bb : loop->get_exit_blocks()) {
+        Instruction *pos = nullptr;
+        for (auto &inst : exit_bb->get_instructions()) {
+            if (not inst.is_phi()) {
+                pos = &inst;
+                break;
+            }
+        }
+        auto val = LoadInst::create_load(alloca, exit_bb);
+        exit_bb->remove_instr(val);
+        exit_bb->insert_before(pos, val);
+        auto write_back = StoreInst::create_store(val, global, exit_bb);
+        exit_bb->remove_instr(write_back);
+        exit_bb->insert_before(pos, write_back);
+    }
+}
@@ -0,0 +1,355 @@
+#include "LoopVersioning.hpp"
+#include "BasicBlock.hpp"
+#include "CheckElimination.hpp"
+#include "ConstFolder.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <set>
+
+void LoopVersioning::run() {
+    loop_detection_ = std::make_unique<LoopDetection>(m_);
+    loop_detection_->run();
+    unsigned count = 0;
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration())
+            continue;
+        for (auto loop : loop_detection_->get_loops(&f)) {
+            if (loop->get_sub_loops().empty())
+                count += run_on_loop(loop);
+        }
+    }
+    LOG_INFO << "loop versioning versioned " << count << " loops";
+}
+
+bool LoopVersioning::run_on_loop(Loop *loop) {
+    loop_ = loop;
+    preheader_ = loop->get_preheader();
+    auto latch = loop->get_single_latch();
+    auto header = loop->get_header();
+    if (preheader_ == nullptr or latch == nullptr)
+        return false;
+
+    // 步骤一：header 以 iv op bound 决定是否继续循环
+    auto br = dynamic_cast<BranchInst *>(header->get_terminator());
+    if (br == nullptr or not br->is_cond_br())
+        return false;
+    auto true_bb = br->get_operand(1)->as<BasicBlock>();
+    auto false_bb = br->get_operand(2)->as<BasicBlock>();
+    if (loop->contains(true_bb) == loop->contains(false_bb))
+        return false;
+    bool stay_on_true = loop->contains(true_bb);
+    auto exit_bb = stay_on_true ? false_bb : true_bb;
+    auto cmp = dynamic_cast<ICmpInst *>(br->get_condition());
+    // 兼容 icmp ne/eq (zext cmp), 0 的形式
+    if (cmp != nullptr and (cmp->get_instr_type() == Instruction::ne or
+                            cmp->get_instr_type() == Instruction::eq)) {
+        auto zero = dynamic_cast<ConstantInt *>(cmp->get_operand(1));
+        auto zext = dynamic_cast<ZextInst *>(cmp->get_operand(0));
+        if (zero != nullptr and zero->get_value() == 0 and zext != nullptr) {
+            if (cmp->get_instr_type() == Instruction::eq)
+                stay_on_true = not stay_on_true;
+            cmp = dynamic_cast<ICmpInst *>(zext->get_operand(0));
+        }
+    }
+    if (cmp == nullptr)
+        return false;
+    auto op = cmp->get_instr_type();
+    if (not stay_on_true)
+        op = ConstFolder::invert_predicate(op);
+    iv_ = dynamic_cast<PhiInst *>(cmp->get_operand(0));
+    Value *bound = cmp->get_operand(1);
+    if (iv_ == nullptr or iv_->get_parent() != header) {
+        iv_ = dynamic_cast<PhiInst *>(cmp->get_operand(1));
+        bound = cmp->get_operand(0);
+        op = ConstFolder::swap_predicate(op);
+    }
+    if (iv_ == nullptr or iv_->get_parent() != header or
+        not loop->is_invariant(bound))
+        return false;
+
+    // 步骤二：iv = phi [init, preheader], [iv + step, latch]
+    if (iv_->get_num_operand() != 4)
+        return false;
+    Value *init = nullptr, *next = nullptr;
+    for (auto [val, bb] : iv_->get_phi_pairs()) {
+        if (bb == preheader_)
+            init = val;
+        else if (bb == latch)
+            next = val;
+    }
+    auto next_inst = dynamic_cast<IBinaryInst *>(next);
+    if (init == nullptr or next_inst == nullptr)
+        return false;
+    long long step = 0;
+    auto step_val = dynamic_cast<ConstantInt *>(next_inst->get_operand(1));
+    if (next_inst->is_add() and next_inst->get_operand(0) == iv_ and step_val)
+        step = step_val->get_value();
+    else if (next_inst->is_sub() and next_inst->get_operand(0) == iv_ and
+             step_val)
+        step = -(long long)step_val->get_value();
+    else if (next_inst->is_add() and next_inst->get_operand(1) == iv_) {
+        if (auto c = dynamic_cast<ConstantInt *>(next_inst->get_operand(0)))
+            step = c->get_value();
+    }
+    if (step == 0 or step > MAX_SCALE or step < -MAX_SCALE)
+        return false;
+    // 进入循环体时 iv 位于 [init, last]（递增）或 [last, init]（递减）之间
+    bool increasing = step > 0;
+    if (increasing and op != Instruction::lt and op != Instruction::le)
+        return false;
+    if (not increasing and op != Instruction::gt and op != Instruction::ge)
+        return false;
+
+    // 步骤三：除退出块外，循环只能流向负下标异常块
+    if (exit_bb->get_pre_basic_blocks().size() != 1)
+        return false;
+    for (auto bb : loop->get_exit_blocks()) {
+        if (bb != exit_bb and not CheckElimination::is_except_block(bb))
+            return false;
+    }
+
+    // 步骤四：收集下标为 iv 仿射函数的检查，offset 等在 preheader 中计算
+    builder_.set_insert_point(preheader_->get_terminator());
+    std::vector<Check> checks;
+    for (auto bb : loop->get_blocks()) {
+        if (bb == header)
+            continue;
+        auto check = dynamic_cast<BranchInst *>(bb->get_terminator());
+        if (check == nullptr or not check->is_cond_br())
+            continue;
+        auto cond = dynamic_cast<ICmpInst *>(check->get_condition());
+        if (cond == nullptr or cond->get_instr_type() != Instruction::lt)
+            continue;
+        auto zero = dynamic_cast<ConstantInt *>(cond->get_operand(1));
+        auto except_bb = check->get_operand(1)->as<BasicBlock>();
+        if (zero == nullptr or zero->get_value() != 0 or
+            loop->contains(except_bb) or
+            not CheckElimination::is_except_block(except_bb))
+            continue;
+        long long scale;
+        Value *offset;
+        if (get_affine(cond->get_operand(0), scale, offset))
+            checks.push_back({check, scale, offset});
+    }
+    if (checks.empty())
+        return false;
+
+    // 步骤五：生成运行时判断，并复制出无检查的循环
+    Value *last = bound;
+    if (op == Instruction::lt)
+        last = builder_.create_isub(bound, ConstantInt::get(1, m_));
+    else if (op == Instruction::gt)
+        last = builder_.create_iadd(bound, ConstantInt::get(1, m_));
+    auto guard = create_guard(init, last, step, checks);
+    if (guard == nullptr)
+        return false;
+
+    auto f = header->get_parent();
+    auto fast_entry = BasicBlock::create(m_, "", f);
+    auto slow_entry = BasicBlock::create(m_, "", f);
+    preheader_->erase_instr(preheader_->get_terminator());
+    BranchInst::create_cond_br(guard, fast_entry, slow_entry, preheader_);
+    BranchInst::create_br(header, slow_entry);
+    clone_loop(exit_bb, fast_entry, slow_entry, checks);
+    f->reset_bbs();
+    LOG_DEBUG << "versioned loop " << header->get_name() << " with "
+              << checks.size() << " checks removed";
+    return true;
+}
+
+bool LoopVersioning::get_affine(Value *val, long long &scale,
+                                Value *&offset) {
+    if (val == iv_) {
+        scale = 1;
+        offset = ConstantInt::get(0, m_);
+        return true;
+    }
+    if (loop_->is_invariant(val)) {
+        scale = 0;
+        offset = val;
+        return true;
+    }
+    auto inst = dynamic_cast<IBinaryInst *>(val);
+    if (inst == nullptr)
+        return false;
+    long long scale0, scale1;
+    Value *offset0, *offset1;
+    if (not get_affine(inst->get_operand(0), scale0, offset0) or
+        not get_affine(inst->get_operand(1), scale1, offset1))
+        return false;
+    switch (inst->get_instr_type()) {
+    case Instruction::add:
+        scale = scale0 + scale1;
+        break;
+    case Instruction::sub:
+        scale = scale0 - scale1;
+        break;
+    case Instruction::mul: {
+        // 只允许乘以常量
+        auto c0 = dynamic_cast<ConstantInt *>(inst->get_operand(0));
+        auto c1 = dynamic_cast<ConstantInt *>(inst->get_operand(1));
+        if (c1 != nullptr)
+            scale = scale0 * c1->get_value();
+        else if (c0 != nullptr)
+            scale = scale1 * c0->get_value();
+        else if (scale0 == 0 and scale1 == 0)
+            scale = 0;
+        else
+            return false;
+        break;
+    }
+    default:
+        return false;
+    }
+    if (scale > MAX_SCALE or scale < -MAX_SCALE)
+        return false;
+    // offset 按 32 位回绕计算，与循环中下标的计算结果同余
+    switch (inst->get_instr_type()) {
+    case Instruction::add:
+        offset = builder_.create_iadd(offset0, offset1);
+        break;
+    case Instruction::sub:
+        offset = builder_.create_isub(offset0, offset1);
+        break;
+    default:
+        offset = builder_.create_imul(offset0, offset1);
+        break;
+    }
+    return true;
+}
+
+Value *LoopVersioning::create_guard(Value *first, Value *last, long long step,
+                                    const std::vector<Check> &checks) {
+    std::vector<Value *> conds;
+    auto limit = ConstantInt::get(LIMIT, m_);
+    auto neg_limit = ConstantInt::get(-LIMIT, m_);
+    auto add_range_cond = [&](Value *val) {
+        conds.push_back(builder_.create_icmp_ge(val, neg_limit));
+        conds.push_back(builder_.create_icmp_le(val, limit));
+    };
+    // 各端点绝对值不超过 LIMIT 时，iv 与下标的计算都不会溢出
+    add_range_cond(first);
+    add_range_cond(last);
+    for (auto &check : checks) {
+        add_range_cond(check.offset);
+        // 下标在第一次或最后一次迭代时取得最小值
+        auto at = check.scale * step > 0 ? first : last;
+        auto scaled =
+            builder_.create_imul(at, ConstantInt::get((int)check.scale, m_));
+        auto min_idx = builder_.create_iadd(scaled, check.offset);
+        conds.push_back(
+            builder_.create_icmp_ge(min_idx, ConstantInt::get(0, m_)));
+    }
+
+    // LightIR 没有逻辑与，将各条件零扩展后求和判断
+    Value *sum = ConstantInt::get(0, m_);
+    int expected = 0;
+    for (auto cond : conds) {
+        if (auto c = dynamic_cast<ConstantInt *>(cond)) {
+            if (c->get_value() == 0)
+                return nullptr;
+            continue;
+        }
+        auto ext = builder_.create_zext(cond, m_->get_int32_type());
+        sum = builder_.create_iadd(sum, ext);
+        expected++;
+    }
+    return builder_.create_icmp_eq(sum, ConstantInt::get(expected, m_));
+}
+
+void LoopVersioning::clone_loop(BasicBlock *exit_bb, BasicBlock *fast_entry,
+                                BasicBlock *slow_entry,
+                                const std::vector<Check> &checks) {
+    auto header = loop_->get_header();
+    auto f = header->get_parent();
+    std::set<Instruction *> removed;
+    for (auto &check : checks)
+        removed.insert(check.br);
+
+    std::map<Value *, Value *> v_map;
+    v_map[preheader_] = fast_entry;
+    std::vector<BasicBlock *> blocks, new_blocks;
+    for (auto &bb : f->get_basic_blocks()) {
+        if (loop_->contains(&bb))
+            blocks.push_back(&bb);
+    }
+    for (auto bb : blocks) {
+        auto bb_new = BasicBlock::create(m_, "", f);
+        v_map[bb] = bb_new;
+        new_blocks.push_back(bb_new);
+        for (auto &inst : bb->get_instructions()) {
+            Instruction *inst_new;
+            if (removed.count(&inst)) {
+                // 已证明非负的检查直接跳转到正常分支
+                inst_new = BranchInst::create_br(
+                    inst.get_operand(2)->as<BasicBlock>(), bb_new);
+            } else if (inst.is_call()) {
+                // CallInst::clone 依赖未初始化的 func_，与 FunctionInline 一样手动复制
+                auto func = inst.get_operand(0)->as<Function>();
+                inst_new = new CallInst(func,
+                                        {inst.get_operands().begin() + 1,
+                                         inst.get_operands().end()},
+                                        bb_new);
+            } else {
+                inst_new = inst.clone(bb_new);
+                if (inst.is_phi())
+                    bb_new->add_instruction(inst_new);
+            }
+            v_map[&inst] = inst_new;
+        }
+    }
+    auto mapped = [&](Value *val) {
+        auto it = v_map.find(val);
+        return it == v_map.end() ? val : it->second;
+    };
+    for (auto bb : new_blocks) {
+        for (auto &inst : bb->get_instructions()) {
+            for (unsigned i = 0; i < inst.get_num_operand(); i++)
+                inst.set_operand(i, mapped(inst.get_operand(i)));
+        }
+    }
+    BranchInst::create_br(mapped(header)->as<BasicBlock>(), fast_entry);
+
+    // 原循环改由 slow_entry 进入
+    header->replace_phi_pred(preheader_, slow_entry);
+
+    // 退出块中已有的 phi 补充来自副本的入边
+    for (auto &inst : exit_bb->get_instructions()) {
+        if (not inst.is_phi())
+            break;
+        auto phi = static_cast<PhiInst *>(&inst);
+        for (auto [val, pred] : phi->get_phi_pairs()) {
+            if (loop_->contains(pred))
+                phi->add_phi_pair_operand(mapped(val), mapped(pred));
+        }
+    }
+
+    // 循环中定义、在循环外使用的值，在退出块中用 phi 合并两个版本
+    std::set<BasicBlock *> new_block_set(new_blocks.begin(), new_blocks.end());
+    for (auto bb : blocks) {
+        for (auto &inst : bb->get_instructions()) {
+            std::vector<std::pair<Instruction *, unsigned>> outside_uses;
+            for (auto &use : inst.get_use_list()) {
+                auto user = dynamic_cast<Instruction *>(use.val_);
+                auto user_bb = user->get_parent();
+                if (loop_->contains(user_bb) or new_block_set.count(user_bb))
+                    continue;
+                if (user->is_phi() and user_bb == exit_bb and
+                    loop_->contains(
+                        user->get_operand(use.arg_no_ + 1)->as<BasicBlock>()))
+                    continue;
+                outside_uses.push_back({user, use.arg_no_});
+            }
+            if (outside_uses.empty())
+                continue;
+            auto phi = PhiInst::create_phi(inst.get_type(), exit_bb);
+            exit_bb->add_instr_begin(phi);
+            phi->add_phi_pair_operand(&inst, header);
+            phi->add_phi_pair_operand(mapped(&inst), mapped(header));
+            for (auto [user, idx] : outside_uses)
+                user->set_operand(idx, phi);
+        }
+    }
+}
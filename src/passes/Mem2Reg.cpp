@@ -1,5 +1,6 @@
 #include "Mem2Reg.hpp"
-#include "IRBuilder.hpp"
+#include "Constant.hpp"
+#include "IDFCalculator.hpp"
 #include "Value.hpp"
 
 #include <memory>
@@ -14,147 +15,239 @@ void Mem2Reg::run() {
         if (f.is_declaration())
             continue;
         func_ = &f;
-        var_val_stack.clear();
-        phi_lval.clear();
-        if (func_->get_basic_blocks().size() >= 1) {
-            // 对应伪代码中 phi 指令插入的阶段
-            generate_phi();
-            // 对应伪代码中重命名阶段
-            rename(func_->get_entry_block());
+        allocas_.clear();
+        var_index_.clear();
+        phi_var_.clear();
+        visited_.clear();
+        collect_allocas();
+        if (allocas_.empty())
+            continue;
+        // 对应伪代码中 phi 指令插入的阶段
+        generate_phi();
+        // 对应伪代码中重命名阶段
+        rename();
+        remove_trivial_phi();
+    }
+}
+
+bool Mem2Reg::is_promotable(AllocaInst *alloca) {
+    if (alloca->get_alloca_type()->is_array_type())
+        return false;
+    for (auto &use : alloca->get_use_list()) {
+        auto inst = dynamic_cast<Instruction *>(use.val_);
+        if (inst == nullptr)
+            return false;
+        // store 只能以 alloca 为地址，不能把 alloca 本身存入内存
+        if (not inst->is_load() and not(inst->is_store() and use.arg_no_ == 1))
+            return false;
+    }
+    return true;
+}
+
+Value *Mem2Reg::get_zero(Type *ty) {
+    if (ty->is_integer_type())
+        return ConstantInt::get(0, m_);
+    if (ty->is_float_type())
+        return ConstantFP::get(0., m_);
+    return ConstantZero::get(ty, m_);
+}
+
+void Mem2Reg::collect_allocas() {
+    for (auto &bb : func_->get_basic_blocks()) {
+        for (auto &instr : bb.get_instructions()) {
+            auto alloca = dynamic_cast<AllocaInst *>(&instr);
+            if (alloca != nullptr and is_promotable(alloca)) {
+                var_index_[alloca] = allocas_.size();
+                allocas_.push_back(alloca);
+            }
         }
-        // 后续 DeadCode 将移除冗余的局部变量的分配空间
     }
 }
 
 void Mem2Reg::generate_phi() {
-    // global_live_var_name 是全局名字集合，以 alloca 出的局部变量来统计。
-    // 步骤一：找到活跃在多个 block 的全局名字集合，以及它们所属的 bb 块
-    std::set<Value *> global_live_var_name;
-    std::map<Value *, std::set<BasicBlock *>> live_var_2blocks;
+    auto var_num = allocas_.size();
+    // 步骤一：统计每个变量的定值块，以及在块内先于定值被读取（向上暴露）的块
+    std::vector<std::set<BasicBlock *>> def_blocks(var_num);
+    std::vector<std::set<BasicBlock *>> live_in(var_num);
     for (auto &bb : func_->get_basic_blocks()) {
-        std::set<Value *> var_is_killed;
+        std::vector<bool> defined(var_num, false);
         for (auto &instr : bb.get_instructions()) {
             if (instr.is_store()) {
-                // store i32 a, i32 *b
-                // a is r_val, b is l_val
-                auto l_val = static_cast<StoreInst *>(&instr)->get_lval();
-                if (is_valid_ptr(l_val)) {
-                    global_live_var_name.insert(l_val);
-                    live_var_2blocks[l_val].insert(&bb);
+                auto idx = get_index(static_cast<StoreInst *>(&instr)->get_lval());
+                if (idx >= 0) {
+                    def_blocks[idx].insert(&bb);
+                    defined[idx] = true;
                 }
+            } else if (instr.is_load()) {
+                auto idx = get_index(static_cast<LoadInst *>(&instr)->get_lval());
+                if (idx >= 0 and not defined[idx])
+                    live_in[idx].insert(&bb);
             }
         }
     }
 
-    // 步骤二：从支配树获取支配边界信息，并在对应位置插入 phi 指令
-    std::map<std::pair<BasicBlock *, Value *>, bool>
-        bb_has_var_phi; // bb has phi for var
-    for (auto var : global_live_var_name) {
-        std::vector<BasicBlock *> work_list;
-        work_list.assign(live_var_2blocks[var].begin(),
-                         live_var_2blocks[var].end());
-        for (unsigned i = 0; i < work_list.size(); i++) {
-            auto bb = work_list[i];
-            for (auto bb_dominance_frontier_bb :
-                 dominators_->get_dominance_frontier(bb)) {
-                if (bb_has_var_phi.find({bb_dominance_frontier_bb, var}) ==
-                    bb_has_var_phi.end()) {
-                    // generate phi for bb_dominance_frontier_bb & add
-                    // bb_dominance_frontier_bb to work list
-                    auto phi = PhiInst::create_phi(
-                        var->get_type()->get_pointer_element_type(),
-                        bb_dominance_frontier_bb);
-                    phi_lval.emplace(phi, var);
-                    bb_dominance_frontier_bb->add_instr_begin(phi);
-                    work_list.push_back(bb_dominance_frontier_bb);
-                    bb_has_var_phi[{bb_dominance_frontier_bb, var}] = true;
-                }
+    IDFCalculator idf(dominators_.get());
+    std::vector<BasicBlock *> phi_blocks;
+    for (unsigned var = 0; var < var_num; var++) {
+        // 步骤二：沿前驱反向传播，得到变量活跃的入口块集合
+        std::vector<BasicBlock *> work_list(live_in[var].begin(),
+                                            live_in[var].end());
+        while (not work_list.empty()) {
+            auto bb = work_list.back();
+            work_list.pop_back();
+            for (auto pred : bb->get_pre_basic_blocks()) {
+                if (def_blocks[var].count(pred))
+                    continue;
+                if (live_in[var].insert(pred).second)
+                    work_list.push_back(pred);
             }
         }
+
+        // 步骤三：在迭代支配边界中变量活跃的块上放置 phi
+        auto ty = allocas_[var]->get_alloca_type();
+        idf.set_def_blocks(def_blocks[var]);
+        idf.set_live_in_blocks(live_in[var]);
+        idf.calculate(phi_blocks);
+        for (auto bb : phi_blocks) {
+            auto phi = PhiInst::create_phi(ty, bb);
+            bb->add_instr_begin(phi);
+            phi_var_.emplace(phi, var);
+        }
     }
 }
 
-void Mem2Reg::rename(BasicBlock *bb) {
-    // 步骤一：将 phi 指令作为 lval 的最新定值，lval 即是为局部变量
-    // alloca出的地址空间 步骤二：用 lval 最新的定值替代对应的load指令
-    // 步骤三：将store 指令的 rval，也即被存入内存的值，作为 lval 的最新定值
-    // 步骤四：为lval 对应的 phi 指令参数补充完整
-    // 步骤五：对 bb在支配树上的所有后继节点，递归执行 re_name 操作
-    // 步骤六：pop出 lval的最新定值
-    // 步骤七：清除冗余的指令
-    std::vector<Instruction *> wait_delete;
-
-    // 步骤三：将 phi 指令作为 lval 的最新定值，lval 即是为局部变量 alloca
-    // 出的地址空间
-    for (auto &instr : bb->get_instructions()) {
-        if (instr.is_phi()) {
-            auto l_val = phi_lval.at(static_cast<PhiInst *>(&instr));
-            var_val_stack[l_val].push_back(&instr);
+void Mem2Reg::rename() {
+    std::vector<Value *> init_values;
+    for (auto alloca : allocas_)
+        init_values.push_back(get_zero(alloca->get_alloca_type()));
+
+    std::vector<RenameState> work_list;
+    work_list.push_back({func_->get_entry_block(), nullptr, init_values});
+    while (not work_list.empty()) {
+        auto state = std::move(work_list.back());
+        work_list.pop_back();
+        auto bb = state.bb;
+        auto &values = state.values;
+
+        // 为 phi 补充来自 pred 的参数
+        if (state.pred != nullptr) {
+            for (auto &instr : bb->get_instructions()) {
+                if (not instr.is_phi())
+                    break;
+                auto phi = static_cast<PhiInst *>(&instr);
+                auto iter = phi_var_.find(phi);
+                if (iter != phi_var_.end())
+                    phi->add_phi_pair_operand(values[iter->second], state.pred);
+            }
         }
-    }
+        if (not visited_.insert(bb).second)
+            continue;
 
-    for (auto &instr : bb->get_instructions()) {
-        // 步骤四：用 lval 最新的定值替代对应的load指令
-        if (instr.is_load()) {
-            auto l_val = static_cast<LoadInst *>(&instr)->get_lval();
-            if (is_valid_ptr(l_val)) {
-                if (var_val_stack.find(l_val) != var_val_stack.end()) {
-                    // 此处指令替换会维护 UD 链与 DU 链
-                    instr.replace_all_use_with(var_val_stack[l_val].back());
+        // 将 phi 作为变量的最新定值，用最新定值替换 load，
+        // 并以 store 存入的值作为变量的最新定值
+        std::vector<Instruction *> wait_delete;
+        for (auto &instr : bb->get_instructions()) {
+            if (instr.is_phi()) {
+                auto iter = phi_var_.find(static_cast<PhiInst *>(&instr));
+                if (iter != phi_var_.end())
+                    values[iter->second] = &instr;
+            } else if (instr.is_load()) {
+                auto idx = get_index(static_cast<LoadInst *>(&instr)->get_lval());
+                if (idx >= 0) {
+                    instr.replace_all_use_with(values[idx]);
+                    wait_delete.push_back(&instr);
+                }
+            } else if (instr.is_store()) {
+                auto store = static_cast<StoreInst *>(&instr);
+                auto idx = get_index(store->get_lval());
+                if (idx >= 0) {
+                    values[idx] = store->get_rval();
                     wait_delete.push_back(&instr);
                 }
             }
         }
-        // 步骤五：将 store 指令的 rval，也即被存入内存的值，作为 lval
-        // 的最新定值
-        if (instr.is_store()) {
-            auto l_val = static_cast<StoreInst *>(&instr)->get_lval();
-            auto r_val = static_cast<StoreInst *>(&instr)->get_rval();
-            if (is_valid_ptr(l_val)) {
-                var_val_stack[l_val].push_back(r_val);
+        for (auto instr : wait_delete)
+            bb->erase_instr(instr);
+
+        std::set<BasicBlock *> succs(bb->get_succ_basic_blocks().begin(),
+                                     bb->get_succ_basic_blocks().end());
+        for (auto succ : succs)
+            work_list.push_back({succ, bb, values});
+    }
+
+    // 不可达块中的访问按零值处理，不可达前驱给 phi 提供零值
+    for (auto &bb : func_->get_basic_blocks()) {
+        if (visited_.count(&bb))
+            continue;
+        std::vector<Instruction *> wait_delete;
+        for (auto &instr : bb.get_instructions()) {
+            if (instr.is_load() or instr.is_store()) {
+                auto ptr = instr.is_load()
+                               ? static_cast<LoadInst *>(&instr)->get_lval()
+                               : static_cast<StoreInst *>(&instr)->get_lval();
+                auto idx = get_index(ptr);
+                if (idx < 0)
+                    continue;
+                if (instr.is_load())
+                    instr.replace_all_use_with(
+                        get_zero(allocas_[idx]->get_alloca_type()));
                 wait_delete.push_back(&instr);
             }
         }
+        for (auto instr : wait_delete)
+            bb.erase_instr(instr);
     }
-
-    // 步骤六：为 lval 对应的 phi 指令参数补充完整
-    for (auto succ_bb : bb->get_succ_basic_blocks()) {
-        for (auto &instr : succ_bb->get_instructions()) {
-            if (instr.is_phi()) {
-                auto l_val = phi_lval.at(static_cast<PhiInst *>(&instr));
-                if (var_val_stack.find(l_val) != var_val_stack.end() &&
-                    var_val_stack[l_val].size() != 0) {
-                    static_cast<PhiInst *>(&instr)->add_phi_pair_operand(
-                        var_val_stack[l_val].back(), bb);
-                }
-                // 对于 phi 参数只有一个前驱定值的情况，将会输出 [ undef, bb ]
-                // 的参数格式
-            }
+    for (auto [phi, var] : phi_var_) {
+        auto bb = phi->get_parent();
+        std::set<BasicBlock *> incoming;
+        for (auto [val, pred] : phi->get_phi_pairs())
+            incoming.insert(pred);
+        for (auto pred : bb->get_pre_basic_blocks()) {
+            if (incoming.insert(pred).second)
+                phi->add_phi_pair_operand(
+                    get_zero(allocas_[var]->get_alloca_type()), pred);
         }
     }
 
-    // 步骤七：对 bb 在支配树上的所有后继节点，递归执行 re_name 操作
-    for (auto dom_succ_bb : dominators_->get_dom_tree_succ_blocks(bb)) {
-        rename(dom_succ_bb);
-    }
+    for (auto alloca : allocas_)
+        alloca->get_parent()->erase_instr(alloca);
+}
 
-    // 步骤八：pop出 lval 的最新定值
-    for (auto &instr : bb->get_instructions()) {
-        if (instr.is_store()) {
-            auto l_val = static_cast<StoreInst *>(&instr)->get_lval();
-            if (is_valid_ptr(l_val)) {
-                var_val_stack[l_val].pop_back();
-            }
-        } else if (instr.is_phi()) {
-            auto l_val = phi_lval.at(static_cast<PhiInst *>(&instr));
-            if (var_val_stack.find(l_val) != var_val_stack.end()) {
-                var_val_stack[l_val].pop_back();
+void Mem2Reg::remove_trivial_phi() {
+    // 所有参数都相同（或为 phi 自身）的 phi 可以直接替换为该参数
+    std::set<PhiInst *> alive;
+    std::vector<PhiInst *> work_list;
+    for (auto [phi, var] : phi_var_) {
+        alive.insert(phi);
+        work_list.push_back(phi);
+    }
+    while (not work_list.empty()) {
+        auto phi = work_list.back();
+        work_list.pop_back();
+        if (not alive.count(phi))
+            continue;
+        Value *same = nullptr;
+        bool trivial = true;
+        for (auto [val, pred] : phi->get_phi_pairs()) {
+            if (val == same or val == phi)
+                continue;
+            if (same != nullptr) {
+                trivial = false;
+                break;
             }
+            same = val;
         }
-    }
-
-    // 清除冗余的指令
-    for (auto instr : wait_delete) {
-        bb->erase_instr(instr);
+        if (not trivial)
+            continue;
+        if (same == nullptr)
+            same = get_zero(phi->get_type());
+        for (auto &use : phi->get_use_list()) {
+            auto user = dynamic_cast<PhiInst *>(use.val_);
+            if (user != nullptr and user != phi and alive.count(user))
+                work_list.push_back(user);
+        }
+        phi->replace_all_use_with(same);
+        alive.erase(phi);
+        phi->get_parent()->erase_instr(phi);
     }
 }
@@ -0,0 +1,186 @@
+#include "MemorySSA.hpp"
+#include "Function.hpp"
+#include "IDFCalculator.hpp"
+
+MemorySSA::MemorySSA(Function *func, AliasAnalysis *alias_analysis,
+                     Dominators *dominators)
+    : func_(func), alias_analysis_(alias_analysis), dominators_(dominators) {
+    build();
+}
+
+template <typename T, typename... Args> T *MemorySSA::create(Args &&...args) {
+    auto access = new T(std::forward<Args>(args)..., storage_.size());
+    storage_.emplace_back(access);
+    return access;
+}
+
+void MemorySSA::build() {
+    auto entry = func_->get_entry_block();
+    live_on_entry_ = create<MemoryDef>(nullptr, entry);
+
+    // 为可达块中的访存指令创建节点，并统计定值块
+    std::set<BasicBlock *> def_blocks;
+    for (auto &bb : func_->get_basic_blocks()) {
+        if (dominators_->get_dom_tree_level(&bb) < 0)
+            continue;
+        for (auto &inst : bb.get_instructions()) {
+            if (inst.is_load()) {
+                accesses_[&inst] = create<MemoryUse>(&inst, &bb);
+            } else if (inst.is_store() or
+                       (inst.is_call() and
+                        is_mod(alias_analysis_->get_mod_ref_info(
+                            static_cast<CallInst *>(&inst))))) {
+                accesses_[&inst] = create<MemoryDef>(&inst, &bb);
+                def_blocks.insert(&bb);
+            }
+        }
+    }
+
+    IDFCalculator idf(dominators_);
+    std::vector<BasicBlock *> phi_blocks;
+    idf.set_def_blocks(def_blocks);
+    idf.calculate(phi_blocks);
+    for (auto bb : phi_blocks)
+        phis_[bb] = create<MemoryPhi>(bb);
+
+    // 沿支配树重命名，current 为进入块时的内存定值
+    std::vector<std::pair<BasicBlock *, MemoryAccess *>> work_list;
+    work_list.push_back({entry, live_on_entry_});
+    while (not work_list.empty()) {
+        auto [bb, current] = work_list.back();
+        work_list.pop_back();
+        if (auto phi = get_memory_phi(bb))
+            current = phi;
+        for (auto &inst : bb->get_instructions()) {
+            auto access = get_memory_access(&inst);
+            if (access == nullptr)
+                continue;
+            current->users_.insert(access);
+            if (access->is_use()) {
+                static_cast<MemoryUse *>(access)->defining_ = current;
+            } else {
+                static_cast<MemoryDef *>(access)->defining_ = current;
+                current = access;
+            }
+        }
+        for (auto succ : bb->get_succ_basic_blocks()) {
+            auto phi = get_memory_phi(succ);
+            if (phi == nullptr)
+                continue;
+            phi->incoming_.push_back({current, bb});
+            current->users_.insert(phi);
+        }
+        for (auto child : dominators_->get_dom_tree_succ_blocks(bb))
+            work_list.push_back({child, current});
+    }
+}
+
+bool MemorySSA::is_clobbered_by(MemoryDef *def, const WalkState &state) {
+    auto inst = def->get_instruction();
+    if (inst->is_store())
+        return alias_analysis_->alias(
+                   static_cast<StoreInst *>(inst)->get_lval(), state.ptr,
+                   state.across_iterations) != AliasResult::NoAlias;
+    return is_mod(alias_analysis_->get_mod_ref_info(
+        static_cast<CallInst *>(inst), state.ptr));
+}
+
+// access 处的内存状态是否在进入 bb 时一定已经生效
+bool MemorySSA::dominates(MemoryAccess *access, BasicBlock *bb) {
+    if (access == live_on_entry_)
+        return true;
+    if (access->get_block() == bb)
+        return access->is_phi();
+    return dominators_->is_dominate(access->get_block(), bb);
+}
+
+MemoryAccess *MemorySSA::walk(MemoryAccess *start, WalkState &state) {
+    auto access = start;
+    while (access != live_on_entry_) {
+        if (access->is_phi())
+            return resolve_phi(static_cast<MemoryPhi *>(access), state);
+        auto def = static_cast<MemoryDef *>(access);
+        if (is_clobbered_by(def, state))
+            return def;
+        access = def->get_defining_access();
+    }
+    return access;
+}
+
+MemoryAccess *MemorySSA::resolve_phi(MemoryPhi *phi, WalkState &state) {
+    auto key = std::make_pair(phi, state.across_iterations);
+    auto iter = state.resolved.find(key);
+    if (iter != state.resolved.end())
+        return iter->second;
+    // 正在归结的 phi 再次出现说明沿环回到了自身
+    if (not state.visiting.insert(phi).second)
+        return phi;
+    MemoryAccess *result = nullptr;
+    for (auto [incoming, pred] : phi->get_incoming()) {
+        // 沿回边进入上一次迭代后，循环中的 SSA 值可能已经改变
+        bool across = state.across_iterations;
+        if (dominators_->is_dominate(phi->get_block(), pred))
+            state.across_iterations = true;
+        auto clobber = walk(incoming, state);
+        state.across_iterations = across;
+        if (clobber == phi)
+            continue;
+        if (result == nullptr) {
+            result = clobber;
+        } else if (result != clobber) {
+            result = phi;
+            break;
+        }
+    }
+    if (result == nullptr or not dominates(result, phi->get_block()))
+        result = phi;
+    state.visiting.erase(phi);
+    state.resolved[key] = result;
+    return result;
+}
+
+MemoryAccess *MemorySSA::get_clobbering_access(MemoryAccess *start,
+                                               Value *ptr) {
+    WalkState state{ptr, {}, {}};
+    return walk(start, state);
+}
+
+MemoryAccess *MemorySSA::get_clobbering_access(LoadInst *load) {
+    auto iter = clobber_cache_.find(load);
+    if (iter != clobber_cache_.end())
+        return iter->second;
+    auto use = static_cast<MemoryUse *>(get_memory_access(load));
+    auto clobber =
+        get_clobbering_access(use->get_defining_access(), load->get_lval());
+    clobber_cache_[load] = clobber;
+    return clobber;
+}
+
+void MemorySSA::remove_access(Instruction *inst) {
+    auto access = get_memory_access(inst);
+    if (access == nullptr)
+        return;
+    auto defining = access->is_use()
+                        ? static_cast<MemoryUse *>(access)->defining_
+                        : static_cast<MemoryDef *>(access)->defining_;
+    defining->users_.erase(access);
+    for (auto user : access->users_) {
+        if (user->is_use()) {
+            static_cast<MemoryUse *>(user)->defining_ = defining;
+        } else if (user->is_def()) {
+            static_cast<MemoryDef *>(user)->defining_ = defining;
+        } else {
+            for (auto &[incoming, pred] :
+                 static_cast<MemoryPhi *>(user)->incoming_) {
+                if (incoming == access)
+                    incoming = defining;
+            }
+        }
+        defining->users_.insert(user);
+    }
+    accesses_.erase(inst);
+    if (access->is_use())
+        clobber_cache_.erase(static_cast<LoadInst *>(inst));
+    else
+        clobber_cache_.clear();
+}
@@ -0,0 +1,150 @@
+#include "PartialInline.hpp"
+#include "BasicBlock.hpp"
+#include "CloneFunction.hpp"
+#include "Constant.hpp"
+#include "logging.hpp"
+
+void PartialInline::run() {
+    std::vector<Function *> funcs;
+    for (auto &f : m_->get_functions()) {
+        if (not f.is_declaration() and f.get_name() != "main")
+            funcs.push_back(&f);
+    }
+    for (auto func : funcs) {
+        Guard guard;
+        if (func->get_use_list().empty() or not match_guard(func, guard))
+            continue;
+        auto cold = create_cold_function(func, guard);
+        std::vector<CallInst *> calls;
+        for (auto &use : func->get_use_list()) {
+            auto call = dynamic_cast<CallInst *>(use.val_);
+            if (call != nullptr and use.arg_no_ == 0)
+                calls.push_back(call);
+        }
+        for (auto call : calls)
+            expand_call(call, func, cold, guard);
+        LOG_INFO << "partial inline " << func->get_name() << " at "
+                 << calls.size() << " call sites";
+    }
+}
+
+bool PartialInline::match_guard(Function *func, Guard &guard) {
+    auto entry = func->get_entry_block();
+    auto br = dynamic_cast<BranchInst *>(entry->get_terminator());
+    if (br == nullptr or not br->is_cond_br())
+        return false;
+    // 入口块只能包含只依赖参数与常量的标量计算（alloca 留给函数体）
+    unsigned size = 0;
+    for (auto &inst : entry->get_instructions()) {
+        if (&inst == br or inst.is_alloca())
+            continue;
+        if (not inst.isBinary() and not inst.is_cmp() and not inst.is_fcmp() and
+            not inst.is_zext() and not inst.is_si2fp() and not inst.is_fp2si())
+            return false;
+        for (auto op : inst.get_operands()) {
+            auto op_inst = dynamic_cast<Instruction *>(op);
+            if (op_inst != nullptr and
+                (op_inst->get_parent() != entry or op_inst->is_alloca()))
+                return false;
+        }
+        if (++size > max_guard_size)
+            return false;
+    }
+    // 一侧是只有一条 ret 的块，返回值为参数或常量
+    for (unsigned i = 1; i <= 2; i++) {
+        auto ret_bb = static_cast<BasicBlock *>(br->get_operand(i));
+        auto other = static_cast<BasicBlock *>(br->get_operand(3 - i));
+        if (ret_bb == other or ret_bb->get_instructions().size() != 1)
+            continue;
+        auto ret = dynamic_cast<ReturnInst *>(ret_bb->get_terminator());
+        if (ret == nullptr)
+            continue;
+        Value *val = ret->is_void_ret() ? nullptr : ret->get_operand(0);
+        if (val != nullptr and dynamic_cast<Argument *>(val) == nullptr and
+            dynamic_cast<Constant *>(val) == nullptr)
+            continue;
+        guard = {i == 1, val};
+        return true;
+    }
+    return false;
+}
+
+// 复制函数，并让副本的入口块直接跳转到慢速路径
+Function *PartialInline::create_cold_function(Function *func,
+                                              const Guard &guard) {
+    std::map<Value *, Value *> v_map;
+    auto cold = clone_function(func, func->get_name() + "_cold", v_map);
+    auto entry = cold->get_entry_block();
+    auto br = static_cast<BranchInst *>(entry->get_terminator());
+    auto slow_bb = br->get_operand(guard.return_on_true ? 2 : 1)
+                       ->as<BasicBlock>();
+    entry->erase_instr(br);
+    BranchInst::create_br(slow_bb, entry);
+    return cold;
+}
+
+void PartialInline::expand_call(CallInst *call, Function *func, Function *cold,
+                                const Guard &guard) {
+    auto bb = call->get_parent();
+    auto caller = bb->get_parent();
+    auto after_bb = BasicBlock::create(m_, "", caller);
+    auto slow_bb = BasicBlock::create(m_, "", caller);
+
+    // 调用之后的指令移入 after_bb
+    std::vector<Instruction *> moved;
+    bool found = false;
+    for (auto &inst : bb->get_instructions()) {
+        if (found)
+            moved.push_back(&inst);
+        found |= &inst == call;
+    }
+    for (auto inst : moved) {
+        bb->remove_instr(inst);
+        after_bb->add_instruction(inst);
+        inst->set_parent(after_bb);
+    }
+    bb->remove_instr(call);
+    slow_bb->add_instruction(call);
+    call->set_parent(slow_bb);
+    call->set_operand(0, cold);
+    BranchInst::create_br(after_bb, slow_bb);
+
+    // 在调用点复制入口判断，参数替换为实参
+    std::map<Value *, Value *> v_map;
+    for (auto &arg : func->get_args())
+        v_map[&arg] = call->get_operand(arg.get_arg_no() + 1);
+    auto entry = func->get_entry_block();
+    auto entry_br = static_cast<BranchInst *>(entry->get_terminator());
+    for (auto &inst : entry->get_instructions()) {
+        if (&inst == entry_br or inst.is_alloca())
+            continue;
+        auto inst_new = inst.clone(bb);
+        for (unsigned i = 0; i < inst_new->get_num_operand(); i++) {
+            auto iter = v_map.find(inst_new->get_operand(i));
+            if (iter != v_map.end())
+                inst_new->set_operand(i, iter->second);
+        }
+        v_map[&inst] = inst_new;
+    }
+    auto cond = v_map.count(entry_br->get_condition())
+                    ? v_map[entry_br->get_condition()]
+                    : entry_br->get_condition();
+    if (guard.return_on_true)
+        BranchInst::create_cond_br(cond, after_bb, slow_bb, bb);
+    else
+        BranchInst::create_cond_br(cond, slow_bb, after_bb, bb);
+
+    if (not call->get_type()->is_void_type()) {
+        auto fast_val = v_map.count(guard.ret_val) ? v_map[guard.ret_val]
+                                                   : guard.ret_val;
+        auto phi = PhiInst::create_phi(call->get_type(), after_bb);
+        after_bb->add_instr_begin(phi);
+        call->replace_all_use_with(phi);
+        phi->add_phi_pair_operand(fast_val, bb);
+        phi->add_phi_pair_operand(call, slow_bb);
+    }
+
+    // 后继块中 phi 的来源由 bb 改为 after_bb
+    after_bb->redirect_succ_phis(bb);
+    caller->reset_bbs();
+}
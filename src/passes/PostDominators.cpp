@@ -0,0 +1,125 @@
+#include "PostDominators.hpp"
+#include "Function.hpp"
+
+void PostDominators::run() {
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration())
+            continue;
+        run_on_func(&f);
+    }
+}
+
+void PostDominators::run_on_func(Function *f) {
+    // 允许在 CFG 变化后对同一函数重新分析，需清除上一次的结果
+    for (auto &bb : f->get_basic_blocks()) {
+        ipdom_.erase(&bb);
+        reverse_frontier_[&bb].clear();
+        post_order_.erase(&bb);
+        reaches_return_.erase(&bb);
+        exit_preds_.erase(&bb);
+    }
+    create_post_order(f);
+    create_ipdom();
+    create_reverse_frontier(f);
+}
+
+bool PostDominators::is_post_dominate(BasicBlock *bb1, BasicBlock *bb2) {
+    for (auto bb = bb2; bb != nullptr; bb = get_ipdom(bb)) {
+        if (bb == bb1)
+            return true;
+    }
+    return bb1 == nullptr;
+}
+
+std::vector<BasicBlock *> PostDominators::get_reverse_preds(BasicBlock *bb) {
+    std::vector<BasicBlock *> preds(bb->get_succ_basic_blocks().begin(),
+                                    bb->get_succ_basic_blocks().end());
+    if (exit_preds_.count(bb))
+        preds.push_back(nullptr);
+    return preds;
+}
+
+void PostDominators::dfs(BasicBlock *bb, std::set<BasicBlock *> &visited) {
+    visited.insert(bb);
+    for (auto pred : bb->get_pre_basic_blocks()) {
+        if (not visited.count(pred))
+            dfs(pred, visited);
+    }
+    post_order_vec_.push_back(bb);
+    post_order_[bb] = post_order_vec_.size() - 1;
+}
+
+void PostDominators::create_post_order(Function *f) {
+    post_order_vec_.clear();
+    std::set<BasicBlock *> visited;
+    // 从虚拟出口出发沿逆 CFG 遍历，返回块是虚拟出口的后继
+    for (auto &bb : f->get_basic_blocks()) {
+        if (bb.get_terminator()->is_ret()) {
+            exit_preds_.insert(&bb);
+            if (not visited.count(&bb))
+                dfs(&bb, visited);
+        }
+    }
+    reaches_return_.insert(visited.begin(), visited.end());
+    // 剩余的块无法到达返回块，逐个连向虚拟出口
+    for (auto &bb : f->get_basic_blocks()) {
+        if (visited.count(&bb))
+            continue;
+        exit_preds_.insert(&bb);
+        dfs(&bb, visited);
+    }
+    post_order_[nullptr] = post_order_vec_.size();
+}
+
+BasicBlock *PostDominators::intersect(BasicBlock *b1, BasicBlock *b2) {
+    while (b1 != b2) {
+        while (post_order_.at(b1) < post_order_.at(b2))
+            b1 = get_ipdom(b1);
+        while (post_order_.at(b2) < post_order_.at(b1))
+            b2 = get_ipdom(b2);
+    }
+    return b1;
+}
+
+void PostDominators::create_ipdom() {
+    ipdom_[nullptr] = nullptr;
+    bool changed;
+    do {
+        changed = false;
+        for (auto it = post_order_vec_.rbegin(); it != post_order_vec_.rend();
+             it++) {
+            auto bb = *it;
+            // 以第一个已处理的逆 CFG 前驱作为初值，nullptr 是合法的结果，另行记录
+            BasicBlock *new_ipdom = nullptr;
+            bool found = false;
+            for (auto pred : get_reverse_preds(bb)) {
+                if (not ipdom_.count(pred))
+                    continue;
+                new_ipdom = found ? intersect(pred, new_ipdom) : pred;
+                found = true;
+            }
+            if (not found)
+                continue;
+            auto iter = ipdom_.find(bb);
+            if (iter == ipdom_.end() or iter->second != new_ipdom) {
+                ipdom_[bb] = new_ipdom;
+                changed = true;
+            }
+        }
+    } while (changed);
+}
+
+void PostDominators::create_reverse_frontier(Function *f) {
+    for (auto &bb : f->get_basic_blocks()) {
+        auto preds = get_reverse_preds(&bb);
+        if (preds.size() < 2)
+            continue;
+        auto ipdom = get_ipdom(&bb);
+        for (auto runner : preds) {
+            while (runner != ipdom and runner != nullptr) {
+                reverse_frontier_[runner].insert(&bb);
+                runner = get_ipdom(runner);
+            }
+        }
+    }
+}
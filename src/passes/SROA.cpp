@@ -0,0 +1,76 @@
+#include "SROA.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "logging.hpp"
+
+#include <map>
+
+void SROA::run() {
+    unsigned count = 0;
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration())
+            continue;
+        std::vector<AllocaInst *> allocas;
+        for (auto &bb : f.get_basic_blocks()) {
+            for (auto &inst : bb.get_instructions()) {
+                auto alloca = dynamic_cast<AllocaInst *>(&inst);
+                if (alloca != nullptr and can_split(alloca))
+                    allocas.push_back(alloca);
+            }
+        }
+        for (auto alloca : allocas)
+            split(alloca);
+        count += allocas.size();
+    }
+    LOG_INFO << "sroa: split " << count << " arrays";
+}
+
+// 每个使用都是 gep alloca, 0, c（c 在数组范围内），且 gep 只被用作 load/store 的地址
+bool SROA::can_split(AllocaInst *alloca) {
+    if (not alloca->get_alloca_type()->is_array_type())
+        return false;
+    auto array_ty = static_cast<ArrayType *>(alloca->get_alloca_type());
+    for (auto &use : alloca->get_use_list()) {
+        auto gep = dynamic_cast<GetElementPtrInst *>(use.val_);
+        if (gep == nullptr or use.arg_no_ != 0 or gep->get_num_operand() != 3)
+            return false;
+        auto first = dynamic_cast<ConstantInt *>(gep->get_operand(1));
+        auto idx = dynamic_cast<ConstantInt *>(gep->get_operand(2));
+        if (first == nullptr or first->get_value() != 0 or idx == nullptr or
+            idx->get_value() < 0 or
+            idx->get_value() >= static_cast<int>(array_ty->get_num_of_elements()))
+            return false;
+        for (auto &gep_use : gep->get_use_list()) {
+            auto inst = dynamic_cast<Instruction *>(gep_use.val_);
+            if (inst == nullptr or
+                not(inst->is_load() or (inst->is_store() and gep_use.arg_no_ == 1)))
+                return false;
+        }
+    }
+    return true;
+}
+
+void SROA::split(AllocaInst *alloca) {
+    auto bb = alloca->get_parent();
+    auto elem_ty = alloca->get_alloca_type()->get_array_element_type();
+    // 只为实际访问到的元素创建 alloca
+    std::map<int, AllocaInst *> elems;
+    std::vector<Instruction *> geps;
+    for (auto &use : alloca->get_use_list()) {
+        auto gep = static_cast<Instruction *>(use.val_);
+        auto idx = static_cast<ConstantInt *>(gep->get_operand(2))->get_value();
+        auto &elem = elems[idx];
+        if (elem == nullptr) {
+            elem = AllocaInst::create_alloca(elem_ty, bb);
+            bb->remove_instr(elem);
+            bb->insert_before(alloca, elem);
+        }
+        geps.push_back(gep);
+    }
+    for (auto gep : geps) {
+        auto idx = static_cast<ConstantInt *>(gep->get_operand(2))->get_value();
+        gep->replace_all_use_with(elems[idx]);
+        gep->get_parent()->erase_instr(gep);
+    }
+    bb->erase_instr(alloca);
+}
@@ -0,0 +1,202 @@
+#include "TailRecursionElim.hpp"
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "logging.hpp"
+
+#include <set>
+
+void TailRecursionElim::run() {
+    for (auto &f : m_->get_functions()) {
+        if (f.is_declaration() or f.get_name() == "main")
+            continue;
+        std::vector<TailSite> sites;
+        for (auto &bb : f.get_basic_blocks()) {
+            for (auto &inst : bb.get_instructions()) {
+                TailSite site;
+                if (inst.is_call() and
+                    match_tail_site(&f, static_cast<CallInst *>(&inst), site))
+                    sites.push_back(site);
+            }
+        }
+        if (sites.empty() or has_escaping_alloca(&f, sites))
+            continue;
+        // 所有累加形式必须使用同一种运算
+        std::set<Instruction::OpID> acc_ops;
+        for (auto &site : sites) {
+            if (site.acc_inst != nullptr)
+                acc_ops.insert(site.acc_inst->get_instr_type());
+        }
+        if (acc_ops.size() > 1)
+            continue;
+        eliminate(&f, sites,
+                  acc_ops.empty() ? Instruction::ret : *acc_ops.begin());
+        LOG_INFO << "tail recursion eliminated in " << f.get_name() << ", "
+                 << sites.size() << " call sites";
+    }
+}
+
+bool TailRecursionElim::returns_directly(Instruction *inst, Value *val,
+                                         BasicBlock *&ret_bb) {
+    auto &insts = inst->get_parent()->get_instructions();
+    auto iter = std::next(inst->getIterator());
+    if (iter == insts.end() or
+        (val != nullptr and val->get_use_list().size() != 1))
+        return false;
+    if (iter->is_ret()) {
+        ret_bb = nullptr;
+        return iter->get_num_operand() == 0 or iter->get_operand(0) == val;
+    }
+    auto br = dynamic_cast<BranchInst *>(&*iter);
+    if (br == nullptr or br->is_cond_br())
+        return false;
+    auto succ = static_cast<BasicBlock *>(br->get_operand(0));
+    auto &succ_insts = succ->get_instructions();
+    // 无返回值时跳转到只含 ret void 的返回块
+    if (val == nullptr) {
+        ret_bb = succ;
+        return succ_insts.size() == 1 and succ_insts.back().is_ret();
+    }
+    // 跳转到只含一个 phi 与 ret 的返回块
+    if (succ_insts.size() != 2 or not succ_insts.front().is_phi() or
+        not succ_insts.back().is_ret())
+        return false;
+    auto phi = static_cast<PhiInst *>(&succ_insts.front());
+    if (succ_insts.back().get_operand(0) != phi)
+        return false;
+    for (auto [in_val, pred] : phi->get_phi_pairs()) {
+        if (pred == inst->get_parent() and in_val == val) {
+            ret_bb = succ;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TailRecursionElim::match_tail_site(Function *func, CallInst *call,
+                                        TailSite &site) {
+    if (call->get_operand(0) != func)
+        return false;
+    site = {call, nullptr, nullptr};
+    if (call->get_type()->is_void_type())
+        return returns_directly(call, nullptr, site.ret_bb);
+    if (returns_directly(call, call, site.ret_bb))
+        return true;
+    // 累加形式：r = f(...) op x，且 r 被直接返回
+    if (call->get_use_list().size() != 1)
+        return false;
+    auto acc = dynamic_cast<Instruction *>(call->get_use_list().front().val_);
+    if (acc == nullptr or acc != &*std::next(call->getIterator()) or
+        (not acc->is_add() and not acc->is_mul()))
+        return false;
+    if (acc->get_operand(0) == acc->get_operand(1))
+        return false;
+    site.acc_inst = acc;
+    return returns_directly(acc, acc, site.ret_bb);
+}
+
+bool TailRecursionElim::has_escaping_alloca(
+    Function *func, const std::vector<TailSite> &sites) {
+    for (auto &site : sites) {
+        for (unsigned i = 1; i < site.call->get_num_operand(); i++) {
+            Value *ptr = site.call->get_operand(i);
+            while (auto gep = dynamic_cast<GetElementPtrInst *>(ptr))
+                ptr = gep->get_operand(0);
+            if (dynamic_cast<AllocaInst *>(ptr) != nullptr)
+                return true;
+        }
+    }
+    return false;
+}
+
+void TailRecursionElim::eliminate(Function *func,
+                                  const std::vector<TailSite> &sites,
+                                  Instruction::OpID acc_op) {
+    // 入口块只保留 alloca，其余指令移入新的循环头
+    auto entry = func->get_entry_block();
+    auto header = BasicBlock::create(m_, "", func);
+    std::vector<Instruction *> moved;
+    for (auto &inst : entry->get_instructions()) {
+        if (not inst.is_alloca())
+            moved.push_back(&inst);
+    }
+    for (auto inst : moved) {
+        entry->remove_instr(inst);
+        header->add_instruction(inst);
+        inst->set_parent(header);
+    }
+    BranchInst::create_br(header, entry);
+    header->redirect_succ_phis(entry);
+
+    // 每个参数对应一个 phi
+    std::vector<PhiInst *> arg_phis;
+    for (auto &arg : func->get_args()) {
+        auto phi = PhiInst::create_phi(arg.get_type(), header);
+        header->add_instr_begin(phi);
+        arg.replace_all_use_with(phi);
+        phi->add_phi_pair_operand(&arg, entry);
+        arg_phis.push_back(phi);
+    }
+    // 累加器初值为运算的单位元
+    PhiInst *acc_phi = nullptr;
+    if (acc_op != Instruction::ret) {
+        acc_phi = PhiInst::create_phi(func->get_return_type(), header);
+        header->add_instr_begin(acc_phi);
+        acc_phi->add_phi_pair_operand(
+            ConstantInt::get(acc_op == Instruction::mul ? 1 : 0, m_), entry);
+    }
+
+    // 非递归的返回与累加器合并
+    if (acc_phi != nullptr) {
+        std::set<Instruction *> site_insts;
+        for (auto &site : sites)
+            site_insts.insert(site.acc_inst ? site.acc_inst : site.call);
+        std::vector<Instruction *> rets;
+        for (auto &bb : func->get_basic_blocks()) {
+            auto term = bb.get_terminator();
+            if (term->is_ret() and
+                not site_insts.count(
+                    dynamic_cast<Instruction *>(term->get_operand(0))))
+                rets.push_back(term);
+        }
+        for (auto ret : rets) {
+            auto bb = ret->get_parent();
+            auto val = ret->get_operand(0);
+            bb->erase_instr(ret);
+            auto combined = acc_op == Instruction::mul
+                                ? IBinaryInst::create_mul(acc_phi, val, bb)
+                                : IBinaryInst::create_add(acc_phi, val, bb);
+            ReturnInst::create_ret(combined, bb);
+        }
+    }
+
+    // 尾调用改为跳回循环头
+    for (auto &site : sites) {
+        auto bb = site.call->get_parent();
+        auto last = site.acc_inst ? site.acc_inst : site.call;
+        bb->erase_instr(&*std::next(last->getIterator()));
+        if (site.ret_bb != nullptr) {
+            for (auto &inst : site.ret_bb->get_instructions()) {
+                if (inst.is_phi())
+                    static_cast<PhiInst *>(&inst)->remove_phi_operand(bb);
+            }
+        }
+        for (unsigned i = 0; i < arg_phis.size(); i++)
+            arg_phis[i]->add_phi_pair_operand(site.call->get_operand(i + 1),
+                                              bb);
+        if (acc_phi != nullptr) {
+            if (site.acc_inst != nullptr) {
+                // acc = acc op x
+                for (unsigned i = 0; i < 2; i++) {
+                    if (site.acc_inst->get_operand(i) == site.call)
+                        site.acc_inst->set_operand(i, acc_phi);
+                }
+                acc_phi->add_phi_pair_operand(site.acc_inst, bb);
+            } else {
+                acc_phi->add_phi_pair_operand(acc_phi, bb);
+            }
+        }
+        bb->erase_instr(site.call);
+        BranchInst::create_br(header, bb);
+    }
+    func->reset_bbs();
+}
@@ -101,12 +101,57 @@ lv3 = {
     "complex3": (4, False),
 }
 
+# 优化相关的用例：第三项为额外的编译选项，输出依赖于对应变换的正确性
+opt = {
+    "iv_merge_derived": (1, False, ["-iv-simplify"]),
+    "iv_affine_index": (1, False, ["-iv-simplify"]),
+    "check_elim_loop": (1, False, ["-check-elim"]),
+    "check_elim_neg_cond": (1, False, ["-check-elim"]),
+    "loop_version_checks": (1, False, ["-loop-version"]),
+    "inst_combine_identities": (1, True, ["-inst-combine"]),
+    "bool_conditions": (1, False, ["-no-builder-fold"]),
+    "ssa_scopes": (1, False, []),
+    "const_fold": (1, False, []),
+    "mem2reg_deep": (1, False, ["-no-builder-ssa", "-const-prop"]),
+    "phi_placement": (1, False, ["-no-builder-ssa", "-const-prop"]),
+    "global_opt_locals": (1, False, ["-global-opt"]),
+    "loop_promote_globals": (1, False, ["-loop-promote"]),
+    "sroa_local_arrays": (1, False, ["-sroa"]),
+    "load_store_elim": (1, True, ["-load-store-elim"]),
+    "alias_array_args": (1, False, ["-load-store-elim"]),
+    "memory_ssa_loops": (1, True, ["-load-store-elim"]),
+    "call_graph_sccs": (1, False, ["-func-inline"]),
+    "inline_cost": (1, False, ["-func-inline"]),
+    "partial_inline": (1, False, ["-partial-inline"]),
+    "tail_rec_elim": (1, False, ["-tail-rec-elim"]),
+    "tail_rec_void": (1, False, ["-tail-rec-elim"]),
+    "dead_arg_elim": (1, True, ["-dead-arg-elim"]),
+    "arg_promotion": (1, False, ["-arg-promotion"]),
+    "mod_ref_calls": (1, False, ["-load-store-elim"]),
+    "auto_memoize": (1, True, ["-auto-memoize"]),
+    "adce_control": (1, False, ["-adce"]),
+    "ipsccp_dead_loop": (1, False, ["-ipsccp"]),
+    "ipsccp_dead_loop_adce": (1, False, ["-ipsccp", "-adce"]),
+    "ipsccp_calls": (1, True, ["-ipsccp"]),
+    "alias_iterations": (1, True, ["-iv-simplify", "-load-store-elim"]),
+}
+
 suite = [
     ("lv0_1", lv0_1, 0),
     ("lv0_2", lv0_2, 0),
     ("lv1", lv1, 0),
     ("lv2", lv2, 0),
-    ("lv3", lv3, 0)
+    ("lv3", lv3, 0),
+    ("opt", opt, 0)
+]
+
+# 命令行中可用的优化选项，对应 cminusfc 的同名选项
+OPT_FLAGS = [
+    "dce", "func-inline", "const-prop", "iv-simplify", "check-elim",
+    "loop-version", "inst-combine", "global-opt", "loop-promote", "sroa",
+    "load-store-elim", "partial-inline", "tail-rec-elim", "ipsccp",
+    "dead-arg-elim", "arg-promotion", "auto-memoize", "adce",
+    "no-builder-ssa", "no-builder-fold",
 ]
 
 def eval():
@@ -114,12 +159,8 @@ def eval():
     opt_flags = []
     if len(sys.argv) > 1:
         for arg in sys.argv[1:]:
-            if arg == "dce":
-                opt_flags.append("-dce")
-            elif arg == "func-inline":
-                opt_flags.append("-func-inline")
-            elif arg == "const-prop":
-                opt_flags.append("-const-prop")
+            if arg in OPT_FLAGS:
+                opt_flags.append("-" + arg)
 
     f = open("eval_result", 'w')
     EXE_PATH = "../../../build/cminusfc"
@@ -146,6 +187,7 @@ def eval():
             ANSWER_PATH = ANSWER_BASE_PATH + level_name + "/" + case
             score = cases[case][0]
             need_input = cases[case][1]
+            case_flags = cases[case][2] if len(cases[case]) > 2 else []
 
             COMMAND = [TEST_PATH]
 
@@ -153,6 +195,7 @@ def eval():
                 # 添加优化选项
                 cmd = [EXE_PATH, "-o", TEST_PATH + ".ll", "-emit-llvm"]
                 cmd.extend(opt_flags)  # 添加所有优化选项
+                cmd.extend(f for f in case_flags if f not in opt_flags)
                 cmd.append(TEST_PATH + ".cminus")
                 
                 result = subprocess.run(cmd, stderr=subprocess.PIPE, timeout=1)
@@ -4,10 +4,27 @@
 show_usage() {
     echo "Usage: $0 [options]"
     echo "Options:"
-    echo "  none        - Run without optimization"
-    echo "  dce         - Run with Dead Code Elimination"
-    echo "  func-inline - Run with Function Inline"
-    echo "  const-prop  - Run with Constant Propagation"
+    echo "  none            - Run without optimization"
+    echo "  dce             - Run with Dead Code Elimination"
+    echo "  func-inline     - Run with Function Inline"
+    echo "  const-prop      - Run with Constant Propagation"
+    echo "  iv-simplify     - Run with Induction Variable Simplification"
+    echo "  check-elim      - Run with Negative Index Check Elimination"
+    echo "  loop-version    - Run with Loop Versioning"
+    echo "  inst-combine    - Run with Instruction Combining"
+    echo "  global-opt      - Run with Global Variable Optimization"
+    echo "  loop-promote    - Run with Global Scalar Promotion in Loops"
+    echo "  sroa            - Run with Scalar Replacement of Local Arrays"
+    echo "  load-store-elim - Run with Load Forwarding and Dead Store Elimination"
+    echo "  partial-inline  - Run with Partial Inline"
+    echo "  tail-rec-elim   - Run with Tail Recursion Elimination"
+    echo "  ipsccp          - Run with Interprocedural Sparse Constant Propagation"
+    echo "  dead-arg-elim   - Run with Dead Argument Elimination"
+    echo "  arg-promotion   - Run with Argument Promotion"
+    echo "  auto-memoize    - Run with Automatic Memoization"
+    echo "  adce            - Run with Aggressive Dead Code Elimination"
+    echo "  no-builder-ssa  - Generate alloca/load/store for scalars in IR generation"
+    echo "  no-builder-fold - Disable constant folding in IR generation"
     echo "Example:"
     echo "  $0 dce func-inline      - Run with both DCE and Function Inline"
     echo "  $0 dce const-prop       - Run with both DCE and Constant Propagation"
@@ -26,7 +43,11 @@ fi
 opts=""
 for arg in "$@"; do
     case $arg in
-        "dce"|"func-inline"|"const-prop")
+        "dce"|"func-inline"|"const-prop"|"iv-simplify"|"check-elim"|\
+        "loop-version"|"inst-combine"|"global-opt"|"loop-promote"|"sroa"|\
+        "load-store-elim"|"partial-inline"|"tail-rec-elim"|"ipsccp"|\
+        "dead-arg-elim"|"arg-promotion"|"auto-memoize"|"adce"|\
+        "no-builder-ssa"|"no-builder-fold")
             opts="$opts $arg"
             ;;
         *)